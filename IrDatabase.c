@@ -0,0 +1,158 @@
+/* ================================================================== *\
+   IrDatabase.c
+   Generated by tools/irdb_index.py (see IrDatabase.h): do not edit.
+   74 codes, 2 devices, 61 function names (0 codes skipped).
+\* ================================================================== */
+#include "IrDatabase.h"
+
+
+const struct ir_database_device IrDatabaseDevice[] =
+{
+  {"Samsung", "TV"},
+  {"Memorex", "Audio"},
+};
+
+const char *const IrDatabaseFunction[] =
+{
+  "Power",
+  "TV",
+  "1",
+  "2",
+  "3",
+  "4",
+  "5",
+  "6",
+  "7",
+  "8",
+  "9",
+  "0",
+  "-",
+  "Pre-Ch",
+  "Mute",
+  "Source",
+  "Volume Up",
+  "Volume Down",
+  "Channel Up",
+  "Channel Down",
+  "Menu",
+  "Ch List",
+  "W. Link",
+  "Tools",
+  "Return",
+  "Info",
+  "Exit",
+  "Up",
+  "Down",
+  "Left",
+  "Right",
+  "Enter",
+  "Red",
+  "Green",
+  "Yellow",
+  "Blue",
+  "CC",
+  "MTS",
+  "DMA",
+  "E.Mode",
+  "P.Size",
+  "Fav.Ch.",
+  "Rewind",
+  "Pause",
+  "Forward",
+  "Play",
+  "Stop",
+  "CD door",
+  "Over",
+  "Play / Pause",
+  "Rewind / Down",
+  "Fast forward / Up",
+  "Volume up",
+  "Volume down",
+  "Random / Down",
+  "Repeat / Up",
+  "Set / Memory / Clock",
+  "Tuner",
+  "CD",
+  "Time",
+  "Display",
+};
+
+const struct ir_database_entry IrDatabase[] =
+{
+  {0x252504FB,     1,    52},
+  {0x252505FA,     1,    14},
+  {0x252506F9,     1,    53},
+  {0x252520DF,     1,    49},
+  {0x252528D7,     1,    56},
+  {0x252530CF,     1,    46},
+  {0x252538C7,     1,    54},
+  {0x252540BF,     1,     6},
+  {0x252548B7,     1,     8},
+  {0x252550AF,     1,     7},
+  {0x252558A7,     1,     9},
+  {0x2525609F,     1,     0},
+  {0x25256897,     1,    58},
+  {0x2525708F,     1,    57},
+  {0x25257887,     1,    47},
+  {0x2525807F,     1,     2},
+  {0x25258877,     1,     4},
+  {0x2525906F,     1,     3},
+  {0x25259867,     1,     5},
+  {0x2525A05F,     1,    51},
+  {0x2525A857,     1,    60},
+  {0x2525B04F,     1,    50},
+  {0x2525B847,     1,    59},
+  {0x2525C03F,     1,    10},
+  {0x2525C837,     1,    48},
+  {0x2525D02F,     1,    11},
+  {0x2525D827,     1,    55},
+  {0xE0E000FF,     0,    37},
+  {0xE0E006F9,     0,    27},
+  {0xE0E008F7,     0,    19},
+  {0xE0E010EF,     0,     5},
+  {0xE0E012ED,     0,    44},
+  {0xE0E016E9,     0,    31},
+  {0xE0E01AE5,     0,    24},
+  {0xE0E020DF,     0,     2},
+  {0xE0E022DD,     0,    41},
+  {0xE0E028D7,     0,    33},
+  {0xE0E029D6,     0,    39},
+  {0xE0E030CF,     0,     8},
+  {0xE0E031CE,     0,    22},
+  {0xE0E036C9,     0,    32},
+  {0xE0E040BF,     0,     0},
+  {0xE0E046B9,     0,    30},
+  {0xE0E048B7,     0,    18},
+  {0xE0E050AF,     0,     7},
+  {0xE0E052AD,     0,    43},
+  {0xE0E058A7,     0,    20},
+  {0xE0E0609F,     0,     4},
+  {0xE0E0629D,     0,    46},
+  {0xE0E06897,     0,    35},
+  {0xE0E0708F,     0,    10},
+  {0xE0E07C83,     0,    40},
+  {0xE0E0807F,     0,    15},
+  {0xE0E08679,     0,    28},
+  {0xE0E08877,     0,    11},
+  {0xE0E0906F,     0,     6},
+  {0xE0E0A05F,     0,     3},
+  {0xE0E0A25D,     0,    42},
+  {0xE0E0A45B,     0,    36},
+  {0xE0E0A659,     0,    29},
+  {0xE0E0A857,     0,    34},
+  {0xE0E0B04F,     0,     9},
+  {0xE0E0B44B,     0,    26},
+  {0xE0E0C43B,     0,    12},
+  {0xE0E0C639,     0,    38},
+  {0xE0E0C837,     0,    13},
+  {0xE0E0D02F,     0,    17},
+  {0xE0E0D22D,     0,    23},
+  {0xE0E0D629,     0,    21},
+  {0xE0E0D827,     0,     1},
+  {0xE0E0E01F,     0,    16},
+  {0xE0E0E21D,     0,    45},
+  {0xE0E0F00F,     0,    14},
+  {0xE0E0F807,     0,    25},
+};
+
+const uint32_t IrDatabaseTotal = sizeof(IrDatabase) / sizeof(IrDatabase[0]);
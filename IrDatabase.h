@@ -0,0 +1,42 @@
+/* ================================================================== *\
+   IrDatabase.h
+   Pico-Remote-Analyzer offline infrared code database.
+
+   IrDatabase.c is generated on a host computer by tools/irdb_index.py
+   from an IRDB-style code database (brand, device type, function name,
+   protocol, device, subdevice, function) and built into the firmware,
+   so that the whole index is a constant array resident in flash.
+
+   Every entry holds the 32-bit command as decoded by the firmware
+   (most significant bit first), and the table is sorted by command so
+   that a command is found by binary search. Several entries may share
+   the same command (the same code used by many brands or devices):
+   they are then consecutive in the table.
+\* ================================================================== */
+#ifndef IR_DATABASE_H
+#define IR_DATABASE_H
+
+#include <stdint.h>
+
+/* Brand and device type of a group of codes. */
+struct ir_database_device
+{
+  const char *Brand;         // brand name.
+  const char *Type;          // device type (TV, DVD, ...).
+};
+
+/* One code of the database. */
+struct ir_database_entry
+{
+  uint32_t Code;             // command as decoded by the firmware.
+  uint16_t Device;           // index in IrDatabaseDevice[].
+  uint16_t Function;         // index in IrDatabaseFunction[].
+};
+
+/* Generated tables (see IrDatabase.c). */
+extern const struct ir_database_device IrDatabaseDevice[];
+extern const char *const IrDatabaseFunction[];
+extern const struct ir_database_entry IrDatabase[];
+extern const uint32_t IrDatabaseTotal;
+
+#endif  // IR_DATABASE_H
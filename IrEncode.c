@@ -0,0 +1,158 @@
+/* ================================================================== *\
+   IrEncode.c
+   Pico-Remote-Analyzer infrared protocol encoder (see IrEncode.h).
+
+   Frame layout shared by the protocols below (most significant bit
+   sent first):
+      "get-ready" bit:  HeaderLow Mark  /  HeaderHigh Space
+      data bits:        BitLow Mark  /  ZeroHigh or OneHigh Space
+      stop bit:         BitLow Mark (terminates the last Space)
+
+   The data bits hold AddressBits address bits, then CommandBits
+   command bits, then check bits. When there are as many check bits
+   as command bits, check bits are the complement of the command
+   (as for both remote controls documented in Samsung.c and Memorex.c).
+\* ================================================================== */
+#include <ctype.h>
+#include <stddef.h>
+#include "IrEncode.h"
+#include "Memorex.h"
+#include "Samsung.h"
+
+
+/* Protocols known by the encoder, built from the same parameters as the descriptor of each remote control file. */
+const struct ir_protocol IrProtocolTable[] =
+{
+  SAMSUNG_PROTOCOL,
+  MEMOREX_PROTOCOL
+};
+const uint8_t IrProtocolTotal = sizeof(IrProtocolTable) / sizeof(IrProtocolTable[0]);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=ir_encode_code() */
+/* ------------------------------------------------------------------ *\
+     Build the complete frame (address, command and check bits) of a
+                              protocol.
+\* ------------------------------------------------------------------ */
+uint64_t ir_encode_code(const struct ir_protocol *Protocol, uint32_t Address, uint32_t Command)
+{
+  uint8_t CheckBits;
+
+  uint64_t Check;
+  uint64_t Code;
+
+
+  CheckBits = Protocol->NumberOfBits - Protocol->AddressBits - Protocol->CommandBits;
+  Command  &= (uint32_t)((1ull << Protocol->CommandBits) - 1);
+
+  Check = 0ull;
+  if (CheckBits == Protocol->CommandBits) Check = ~(uint64_t)Command & ((1ull << CheckBits) - 1);
+
+  Code  = (uint64_t)(Address & (uint32_t)((1ull << Protocol->AddressBits) - 1)) << (Protocol->CommandBits + CheckBits);
+  Code |= (uint64_t)Command << CheckBits;
+  Code |= Check;
+
+  return Code;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=ir_encode_frame() */
+/* ------------------------------------------------------------------ *\
+     Write the durations of a frame into Duration (Size entries).
+     Returns the number of durations, 0 if Size is too small.
+\* ------------------------------------------------------------------ */
+uint16_t ir_encode_frame(const struct ir_protocol *Protocol, uint64_t Code, uint32_t *Duration, uint16_t Size)
+{
+  if (Size < ir_encode_length(Protocol)) return 0;
+
+  /* The head returned by the ring wraps to 0 when the frame fills the buffer exactly: return the length instead. */
+  ir_encode_ring(Protocol, Code, Duration, Size, 0);
+
+  return ir_encode_length(Protocol);
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=ir_encode_length() */
+/* ------------------------------------------------------------------ *\
+     Number of durations in one frame of a protocol: "get-ready" bit,
+                      data bits and stop bit.
+\* ------------------------------------------------------------------ */
+uint16_t ir_encode_length(const struct ir_protocol *Protocol)
+{
+  return (Protocol->NumberOfBits * 2) + 3;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=ir_encode_ring() */
+/* ------------------------------------------------------------------ *\
+     Write the durations of a frame into a ring of RingSize entries,
+      starting at Head (wrapping around at the end of the ring), and
+      return the new Head. The caller makes sure there is room for
+                    ir_encode_length() entries.
+\* ------------------------------------------------------------------ */
+uint16_t ir_encode_ring(const struct ir_protocol *Protocol, uint64_t Code, uint32_t *Ring, uint16_t RingSize, uint16_t Head)
+{
+  uint8_t BitNumber;
+
+
+  /* "Get-ready" bit. */
+  Ring[Head] = Protocol->HeaderLow;   if (++Head >= RingSize) Head = 0;
+  Ring[Head] = Protocol->HeaderHigh;  if (++Head >= RingSize) Head = 0;
+
+  /* Data bits, most significant bit first. */
+  for (BitNumber = Protocol->NumberOfBits; BitNumber > 0; --BitNumber)
+  {
+    Ring[Head] = Protocol->BitLow;  if (++Head >= RingSize) Head = 0;
+    Ring[Head] = ((Code >> (BitNumber - 1)) & 0x01) ? Protocol->OneHigh : Protocol->ZeroHigh;
+    if (++Head >= RingSize) Head = 0;
+  }
+
+  /* Stop bit (a last Mark to terminate the Space of the last data bit). */
+  Ring[Head] = Protocol->BitLow;  if (++Head >= RingSize) Head = 0;
+
+  return Head;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=ir_protocol_find() */
+/* ------------------------------------------------------------------ *\
+     Find a protocol of the table by name (case insensitive). Returns
+                          NULL if unknown.
+\* ------------------------------------------------------------------ */
+const struct ir_protocol *ir_protocol_find(const char *Name)
+{
+  uint8_t Index;
+  uint8_t Loop1UInt8;
+
+
+  for (Index = 0; Index < IrProtocolTotal; ++Index)
+  {
+    for (Loop1UInt8 = 0; (Loop1UInt8 < sizeof(IrProtocolTable[0].Name)) && Name[Loop1UInt8] && IrProtocolTable[Index].Name[Loop1UInt8]; ++Loop1UInt8)
+      if (tolower((unsigned char)Name[Loop1UInt8]) != tolower(IrProtocolTable[Index].Name[Loop1UInt8])) break;
+
+    if ((Loop1UInt8 == sizeof(IrProtocolTable[0].Name)) || ((Name[Loop1UInt8] == 0x00) && (IrProtocolTable[Index].Name[Loop1UInt8] == 0x00)))
+      return &IrProtocolTable[Index];
+  }
+
+  return NULL;
+}
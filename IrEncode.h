@@ -0,0 +1,56 @@
+/* ================================================================== *\
+   IrEncode.h
+   Pico-Remote-Analyzer infrared protocol encoder.
+
+   Inverse of the decoder: turns (protocol, address, command) into
+   the Mark / Space durations (in usec) of an infrared frame, the
+   first one being the Mark of the "get-ready" bit.
+
+   Durations are written directly into a buffer (or a ring, such as
+   a DMA ring buffer) provided by the caller: nothing is allocated.
+   This module only depends on the C standard library, so that it may
+   be built on the Pico as well as on a host computer (for testing or
+   for generating timing streams offline).
+\* ================================================================== */
+#ifndef IR_ENCODE_H
+#define IR_ENCODE_H
+
+#include <stdint.h>
+
+/* Protocol descriptor. Every remote control file defines one (IrProtocol) from its own "brand-related" parameters. */
+struct ir_protocol
+{
+  unsigned char Name[16];    // protocol name.
+  uint32_t CarrierFrequency; // carrier frequency (in Hz).
+  uint16_t HeaderLow;        // "get-ready" Low level (in usec).
+  uint16_t HeaderHigh;       // "get-ready" High level (in usec).
+  uint16_t BitLow;           // Low level of every data bit (in usec).
+  uint16_t ZeroHigh;         // High level of a "0" bit (in usec).
+  uint16_t OneHigh;          // High level of a "1" bit (in usec).
+  uint8_t  NumberOfBits;     // number of data bits.
+  uint8_t  AddressBits;      // number of address bits (first bits received).
+  uint8_t  CommandBits;      // number of command bits (following the address bits, the rest being check bits).
+  uint16_t TriggerPoint01;   // trigger point between a "0" bit and a "1" bit (in usec).
+  uint32_t Separator;        // a duration greater than this is a separator (in usec).
+};
+
+/* Protocols known by the encoder (see IrEncode.c). */
+extern const struct ir_protocol IrProtocolTable[];
+extern const uint8_t IrProtocolTotal;
+
+/* Find a protocol of the table by name (case insensitive). Returns NULL if unknown. */
+const struct ir_protocol *ir_protocol_find(const char *Name);
+
+/* Build the complete frame (address, command and check bits) of a protocol. */
+uint64_t ir_encode_code(const struct ir_protocol *Protocol, uint32_t Address, uint32_t Command);
+
+/* Number of durations in one frame of a protocol ("get-ready" bit, data bits and stop bit). */
+uint16_t ir_encode_length(const struct ir_protocol *Protocol);
+
+/* Write the durations of a frame into Duration (Size entries). Returns the number of durations, 0 if Size is too small. */
+uint16_t ir_encode_frame(const struct ir_protocol *Protocol, uint64_t Code, uint32_t *Duration, uint16_t Size);
+
+/* Write the durations of a frame into a ring of RingSize entries, starting at Head. Returns the new Head. */
+uint16_t ir_encode_ring(const struct ir_protocol *Protocol, uint64_t Code, uint32_t *Ring, uint16_t RingSize, uint16_t Head);
+
+#endif  // IR_ENCODE_H
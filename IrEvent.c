@@ -0,0 +1,127 @@
+/* ================================================================== *\
+   IrEvent.c
+   Pico-Remote-Analyzer application interface for decoded commands
+   (see IrEvent.h).
+
+   The queue is lock-free with a single producer (the capture pipeline,
+   calling ir_event_dispatch() from the infrared ISR) and a single
+   consumer (the application, calling ir_event_poll()): only the
+   producer writes IrEventHead and only the consumer writes IrEventTail.
+   Memory barriers use the GCC builtin (a "dmb" on the RP2040), so that
+   this module only depends on the C standard library, like IrEncode.c.
+\* ================================================================== */
+#include <stddef.h>
+#include "IrEvent.h"
+
+
+static void (*IrEventCallback)(struct ir_event *Event);   // application callback (NULL if none).
+static volatile uint8_t  IrEventHead;                     // next free slot in IrEventQueue (written by producer only).
+static struct ir_event   IrEventQueue[IR_EVENT_QUEUE_SIZE];
+static volatile uint8_t  IrEventTail;                     // next event to be polled (written by consumer only).
+static volatile uint32_t IrEventDropCount;                // events dropped because queue was full.
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=ir_event_dispatch() */
+/* ------------------------------------------------------------------ *\
+      Deliver a frame decoded with Protocol to the application: through
+     the registered callback (if any) and the lock-free queue. Returns
+     1 when the queue was empty before this event (the consumer may be
+        sleeping and should be woken up), 0 otherwise.
+\* ------------------------------------------------------------------ */
+uint8_t ir_event_dispatch(const struct ir_protocol *Protocol, uint64_t Code, uint64_t Time)
+{
+  static uint64_t LastCode = 0ull;
+  static uint64_t LastTime = 0ull;
+
+  uint8_t CheckBits;
+  uint8_t FlagWasEmpty;
+  uint8_t NextHead;
+
+  struct ir_event Event;
+
+
+  /* Split frame in address / command / check bits, most significant bits received first. */
+  CheckBits        = Protocol->NumberOfBits - Protocol->AddressBits - Protocol->CommandBits;
+  Event.Protocol   = Protocol->Name;
+  Event.Code       = Code;
+  Event.Address    = (uint32_t)(Code >> (Protocol->CommandBits + CheckBits)) & (uint32_t)((1ull << Protocol->AddressBits) - 1);
+  Event.Command    = (uint32_t)(Code >> CheckBits) & (uint32_t)((1ull << Protocol->CommandBits) - 1);
+  Event.FlagRepeat = ((Code == LastCode) && ((Time - LastTime) < IR_REPEAT_TIME));
+  Event.Time       = Time;
+  LastCode         = Code;
+  LastTime         = Time;
+
+
+  if (IrEventCallback != NULL) IrEventCallback(&Event);
+
+
+  NextHead = (IrEventHead + 1) % IR_EVENT_QUEUE_SIZE;
+  if (NextHead == IrEventTail)
+  {
+    ++IrEventDropCount;
+    return 0;
+  }
+  FlagWasEmpty = (IrEventHead == IrEventTail);
+  IrEventQueue[IrEventHead] = Event;
+  __sync_synchronize();  // event must be complete before being published.
+  IrEventHead = NextHead;
+
+  return FlagWasEmpty;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=ir_event_dropped() */
+/* ------------------------------------------------------------------ *\
+          Number of events dropped because the queue was full.
+\* ------------------------------------------------------------------ */
+uint32_t ir_event_dropped(void)
+{
+  return IrEventDropCount;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=ir_event_poll() */
+/* ------------------------------------------------------------------ *\
+        Retrieve oldest frame decoded. Returns 1 if an event has
+           been copied to Event, 0 if the queue is empty.
+\* ------------------------------------------------------------------ */
+uint8_t ir_event_poll(struct ir_event *Event)
+{
+  if (IrEventTail == IrEventHead) return 0;
+
+  __sync_synchronize();  // read event only after having seen it published.
+  *Event = IrEventQueue[IrEventTail];
+  __sync_synchronize();  // event must be copied before its slot is released.
+  IrEventTail = (IrEventTail + 1) % IR_EVENT_QUEUE_SIZE;
+
+  return 1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=ir_event_register() */
+/* ------------------------------------------------------------------ *\
+     Register a callback called (from interrupt context) for every
+              frame decoded. NULL removes the callback.
+\* ------------------------------------------------------------------ */
+void ir_event_register(void (*Callback)(struct ir_event *Event))
+{
+  IrEventCallback = Callback;
+
+  return;
+}
@@ -0,0 +1,50 @@
+/* ================================================================== *\
+   IrEvent.h
+   Pico-Remote-Analyzer application interface for decoded commands.
+
+   Every infrared frame decoded by the capture pipeline is delivered
+   as an ir_event, as soon as the High level of its last data bit has
+   been received (that is, from the infrared ISR, with a latency bounded
+   by the decoding time of a single frame):
+
+   - either to a callback registered with ir_event_register()
+     (called from interrupt context: keep it short),
+   - or through a lock-free queue polled with ir_event_poll()
+     (single consumer).
+
+   The queue and the callback live in IrEvent.c, which only depends on
+   the C standard library: another Pico project may build it with its
+   own capture code, calling ir_event_dispatch() for every frame decoded.
+\* ================================================================== */
+#ifndef IR_EVENT_H
+#define IR_EVENT_H
+
+#include <stdint.h>
+#include "IrEncode.h"
+
+#define IR_EVENT_QUEUE_SIZE  16      // number of events kept until polled (newest ones are dropped when full).
+#define IR_REPEAT_TIME       200000  // same command received again within this delay (in usec) is flagged as a repeat.
+
+struct ir_event
+{
+  const unsigned char *Protocol;     // protocol name (from protocol descriptor).
+  uint32_t Address;                  // address bits of the frame.
+  uint32_t Command;                  // command bits of the frame.
+  uint64_t Code;                     // complete frame, as recorded in the button list.
+  uint8_t  FlagRepeat;               // same command as previous frame (button held down).
+  uint64_t Time;                     // timer value (in usec) of the first edge of the frame.
+};
+
+/* Deliver a frame decoded with Protocol (from the capture ISR). Returns 1 when the queue was empty before, so that the consumer may be woken up. */
+uint8_t ir_event_dispatch(const struct ir_protocol *Protocol, uint64_t Code, uint64_t Time);
+
+/* Number of events dropped because the queue was full. */
+uint32_t ir_event_dropped(void);
+
+/* Register a callback called from interrupt context for every frame decoded (NULL to unregister). */
+void ir_event_register(void (*Callback)(struct ir_event *Event));
+
+/* Retrieve oldest frame decoded. Returns 1 if an event has been copied to Event, 0 if queue is empty. */
+uint8_t ir_event_poll(struct ir_event *Event);
+
+#endif  // IR_EVENT_H
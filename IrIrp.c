@@ -0,0 +1,684 @@
+/* ================================================================== *\
+   IrIrp.c
+   Pico-Remote-Analyzer IRP notation interpreter (see IrIrp.h).
+
+   The compiler converts every duration to usec once, so that the
+   encoder and the decoder only walk the list of operations:
+   - the encoder emits the durations of every operation, merging
+     consecutive flashes (or gaps) into a single duration;
+   - the decoder matches the durations received against the same
+     operations, trying bit 0 then bit 1 for every bit of a field.
+\* ================================================================== */
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include "IrIrp.h"
+
+
+/* Compiler state. */
+static const char *IrpText;       // beginning of the string being compiled.
+static const char *IrpCursor;     // current position in the string.
+
+/* Encoder state. */
+static uint32_t *IrpOut;          // durations being encoded.
+static uint16_t  IrpOutSize;      // room in IrpOut.
+static uint16_t  IrpOutCount;     // durations written to IrpOut so far.
+static uint8_t   IrpOverflow;     // IrpOut is too small.
+static int32_t   IrpPending;      // flash (> 0) or gap (< 0) not written yet, since it may be merged with the next one.
+
+/* Decoder state. */
+static const volatile uint32_t *IrpIn;  // durations being decoded.
+static uint16_t  IrpInCount;            // number of durations in IrpIn.
+static uint16_t  IrpInIndex;            // next duration of IrpIn.
+static int32_t   IrpRemaining;          // part of current duration not matched yet (> 0 for a flash, < 0 for a gap).
+
+/* Time since the beginning of current frame (in usec), for extents. */
+static uint32_t  IrpFrameTime;
+
+
+static void     irp_blanks(void);
+static uint8_t  irp_duration(const struct irp_program *Program, int32_t *Duration);
+static void     irp_emit(int32_t Duration);
+static void     irp_emit_bits(const struct irp_program *Program, uint32_t Value, uint8_t Bits);
+static uint8_t  irp_expect(int32_t Duration, uint32_t Longest);
+static uint8_t  irp_items(struct irp_program *Program, uint8_t Level);
+static uint8_t  irp_match_bits(const struct irp_program *Program, uint8_t Bits, uint32_t *Value);
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=irp_blanks() */
+/* ------------------------------------------------------------------ *\
+                  Skip blanks in the string being compiled.
+\* ------------------------------------------------------------------ */
+static void irp_blanks(void)
+{
+  while (isspace((unsigned char)*IrpCursor)) ++IrpCursor;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=irp_compile() */
+/* ------------------------------------------------------------------ *\
+     Compile an IRP string: general spec, bit spec and bare items.
+     Parameter specs and definitions that may follow are skipped.
+     Returns 0 on success, otherwise the position (from 1) of the
+                         error in Text.
+\* ------------------------------------------------------------------ */
+uint16_t irp_compile(const char *Text, struct irp_program *Program)
+{
+  char *End;
+
+  double Value;
+
+  uint8_t Bit;
+  uint8_t Count;
+  uint8_t Loop1UInt8;
+
+
+  /* Initializations (IRP defaults). */
+  memset(Program, 0, sizeof(*Program));
+  Program->CarrierFrequency = 38000;
+  Program->Unit             = 1.0f;
+  Program->FlagMsb          = 0;  // least significant bit first.
+  IrpText   = Text;
+  IrpCursor = Text;
+
+
+  /* General spec: {carrier, unit, bit order}. */
+  irp_blanks();
+  if (*IrpCursor == '{')
+  {
+    ++IrpCursor;
+    while (1)
+    {
+      irp_blanks();
+      if (*IrpCursor == '}')
+      {
+        ++IrpCursor;
+        break;
+      }
+
+      if (strncmp(IrpCursor, "msb", 3) == 0)
+      {
+        Program->FlagMsb = 1;
+        IrpCursor += 3;
+      }
+      else if (strncmp(IrpCursor, "lsb", 3) == 0)
+      {
+        Program->FlagMsb = 0;
+        IrpCursor += 3;
+      }
+      else
+      {
+        Value = strtod(IrpCursor, &End);
+        if ((End == IrpCursor) || (Value <= 0.0)) return (uint16_t)(IrpCursor - IrpText) + 1;
+        IrpCursor = End;
+
+        if (*IrpCursor == 'k')
+        {
+          Program->CarrierFrequency = (uint32_t)((Value * 1000.0) + 0.5);
+          ++IrpCursor;
+        }
+        else if (*IrpCursor == 'p')
+        {
+          Program->Unit = (float)((Value * 1000000.0) / Program->CarrierFrequency);
+          ++IrpCursor;
+        }
+        else
+        {
+          if (*IrpCursor == 'u') ++IrpCursor;
+          Program->Unit = (float)Value;
+        }
+      }
+
+      irp_blanks();
+      if (*IrpCursor == ',') ++IrpCursor;
+      else if (*IrpCursor != '}') return (uint16_t)(IrpCursor - IrpText) + 1;
+    }
+  }
+
+
+  /* Bit spec: <bit 0 | bit 1>. */
+  irp_blanks();
+  if (*IrpCursor != '<') return (uint16_t)(IrpCursor - IrpText) + 1;
+  ++IrpCursor;
+  for (Bit = 0; Bit < 2; ++Bit)
+  {
+    Count = 0;
+    while (1)
+    {
+      if (Count >= IRP_MAX_BIT_DURATIONS) return (uint16_t)(IrpCursor - IrpText) + 1;
+      if (irp_duration(Program, &Program->Bit[Bit][Count++])) return (uint16_t)(IrpCursor - IrpText) + 1;
+      irp_blanks();
+      if (*IrpCursor != ',') break;
+      ++IrpCursor;
+    }
+    Program->BitLength[Bit] = Count;
+
+    /* Every bit must begin with a flash, end with a gap and alternate in between (no bi-phase coding). */
+    for (Loop1UInt8 = 0; Loop1UInt8 < Count; ++Loop1UInt8)
+      if ((Program->Bit[Bit][Loop1UInt8] > 0) != ((Loop1UInt8 % 2) == 0)) return (uint16_t)(IrpCursor - IrpText) + 1;
+    if ((Count % 2) != 0) return (uint16_t)(IrpCursor - IrpText) + 1;
+
+    if (*IrpCursor != ((Bit == 0) ? '|' : '>')) return (uint16_t)(IrpCursor - IrpText) + 1;
+    ++IrpCursor;
+  }
+
+
+  /* Bare items: (...). */
+  irp_blanks();
+  if (*IrpCursor != '(') return (uint16_t)(IrpCursor - IrpText) + 1;
+  ++IrpCursor;
+  if (irp_items(Program, 0)) return (uint16_t)(IrpCursor - IrpText) + 1;
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=irp_decode() */
+/* ------------------------------------------------------------------ *\
+     Decode a burst (durations alternating flash / gap, beginning with
+     a flash) with a compiled program. Only the part preceding the
+     repeated part is matched. A variable appearing in several fields
+     (for example F and ~F) must hold the same value in all of them.
+     Returns 0 and the value of every variable on success, 1 otherwise.
+\* ------------------------------------------------------------------ */
+uint8_t irp_decode(const struct irp_program *Program, const volatile uint32_t *Duration, uint16_t StepCount, uint32_t *Variable)
+{
+  const struct irp_op *Op;
+
+  uint8_t Loop1UInt8;
+
+  uint32_t Known[IRP_VARIABLES];
+  uint32_t Mask;
+  uint32_t Minimum;
+  uint32_t Value;
+
+
+  /* Initializations. */
+  IrpIn        = Duration;
+  IrpInCount   = StepCount;
+  IrpInIndex   = 0;
+  IrpRemaining = 0;
+  IrpFrameTime = 0;
+  for (Loop1UInt8 = 0; Loop1UInt8 < IRP_VARIABLES; ++Loop1UInt8)
+  {
+    Known[Loop1UInt8]    = 0;
+    Variable[Loop1UInt8] = 0;
+  }
+
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < Program->OpTotal; ++Loop1UInt8)
+  {
+    Op = &Program->Op[Loop1UInt8];
+
+    switch (Op->Type)
+    {
+      case (IRP_OP_DURATION):
+        if (irp_expect(Op->Value, (uint32_t)abs(Op->Value))) return 1;
+      break;
+
+      case (IRP_OP_EXTENT):
+        /* Any gap long enough completes the frame (the gap following the last flash of a burst is never received). */
+        if (IrpRemaining == 0)
+        {
+          if (IrpInIndex >= IrpInCount) break;
+          IrpRemaining = ((IrpInIndex % 2) == 0) ? (int32_t)IrpIn[IrpInIndex] : -(int32_t)IrpIn[IrpInIndex];
+          ++IrpInIndex;
+        }
+        Minimum = ((uint32_t)Op->Value > IrpFrameTime) ? (((uint32_t)Op->Value - IrpFrameTime) / 2) : 0;
+        if ((IrpRemaining > 0) || ((uint32_t)(-IrpRemaining) < Minimum)) return 1;
+        IrpRemaining = 0;
+        IrpFrameTime = 0;
+      break;
+
+      case (IRP_OP_FIELD):
+      case (IRP_OP_CONSTANT):
+        if (irp_match_bits(Program, Op->Bits, &Value)) return 1;
+        Mask = (uint32_t)((1ull << Op->Bits) - 1);
+
+        if (Op->Type == IRP_OP_CONSTANT)
+        {
+          if (Value != ((uint32_t)Op->Value & Mask)) return 1;
+          break;
+        }
+
+        if (Op->Invert) Value = ~Value & Mask;
+        Value <<= Op->Shift;
+        Mask  <<= Op->Shift;
+        if (Known[Op->Variable] & Mask)
+        {
+          if ((Variable[Op->Variable] & Mask) != Value) return 1;  // check field doesn't match.
+        }
+        else
+        {
+          Variable[Op->Variable] |= Value;
+          Known[Op->Variable]    |= Mask;
+        }
+      break;
+
+      case (IRP_OP_REPEAT):
+      return 0;
+    }
+  }
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=irp_duration() */
+/* ------------------------------------------------------------------ *\
+     Parse a duration: [-]number[m | u | p], without suffix the number
+      is in time units. Converted to usec (negative for a gap).
+                     Returns 1 on error.
+\* ------------------------------------------------------------------ */
+static uint8_t irp_duration(const struct irp_program *Program, int32_t *Duration)
+{
+  char *End;
+
+  double Value;
+
+  int8_t Sign;
+
+
+  irp_blanks();
+  Sign = 1;
+  if (*IrpCursor == '-')
+  {
+    Sign = -1;
+    ++IrpCursor;
+  }
+
+  Value = strtod(IrpCursor, &End);
+  if ((End == IrpCursor) || (Value <= 0.0)) return 1;
+  IrpCursor = End;
+
+  switch (*IrpCursor)
+  {
+    case ('m'):
+      Value *= 1000.0;
+      ++IrpCursor;
+    break;
+
+    case ('u'):
+      ++IrpCursor;
+    break;
+
+    case ('p'):
+      Value *= 1000000.0 / Program->CarrierFrequency;
+      ++IrpCursor;
+    break;
+
+    default:
+      Value *= Program->Unit;
+    break;
+  }
+
+  *Duration = Sign * (int32_t)(Value + 0.5);
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=irp_emit() */
+/* ------------------------------------------------------------------ *\
+     Add a flash (> 0) or a gap (< 0) to the durations being encoded,
+       merging it with the previous one when they are of the same kind.
+\* ------------------------------------------------------------------ */
+static void irp_emit(int32_t Duration)
+{
+  IrpFrameTime += (uint32_t)abs(Duration);
+
+  /* A burst always begins with a flash. */
+  if ((IrpOutCount == 0) && (IrpPending == 0) && (Duration < 0)) return;
+
+  if ((IrpPending == 0) || ((IrpPending > 0) == (Duration > 0)))
+  {
+    IrpPending += Duration;
+    return;
+  }
+
+  if (IrpOutCount < IrpOutSize) IrpOut[IrpOutCount++] = (uint32_t)abs(IrpPending);
+  else IrpOverflow = 1;
+  IrpPending = Duration;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=irp_emit_bits() */
+/* ------------------------------------------------------------------ *\
+       Add the durations of Bits bits of Value, in the bit order of
+                           the program.
+\* ------------------------------------------------------------------ */
+static void irp_emit_bits(const struct irp_program *Program, uint32_t Value, uint8_t Bits)
+{
+  uint8_t Bit;
+  uint8_t Loop1UInt8;
+  uint8_t Loop2UInt8;
+
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < Bits; ++Loop1UInt8)
+  {
+    Bit = (uint8_t)((Value >> ((Program->FlagMsb) ? (Bits - 1 - Loop1UInt8) : Loop1UInt8)) & 0x01);
+    for (Loop2UInt8 = 0; Loop2UInt8 < Program->BitLength[Bit]; ++Loop2UInt8)
+      irp_emit(Program->Bit[Bit][Loop2UInt8]);
+  }
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=irp_encode() */
+/* ------------------------------------------------------------------ *\
+     Encode a burst from the value of every variable: the part
+      preceding the repeated part once, then the repeated part Repeat
+      times. Durations alternate flash / gap, beginning with a flash.
+       Returns the number of durations, 0 if Size is too small.
+\* ------------------------------------------------------------------ */
+uint16_t irp_encode(const struct irp_program *Program, const uint32_t *Variable, uint8_t Repeat, uint32_t *Duration, uint16_t Size)
+{
+  const struct irp_op *Op;
+
+  uint8_t First;
+  uint8_t Last;
+  uint8_t Loop1UInt8;
+  uint8_t Pass;
+  uint8_t RepeatStart;
+
+  uint32_t Value;
+
+
+  /* Initializations. */
+  IrpOut      = Duration;
+  IrpOutSize  = Size;
+  IrpOutCount = 0;
+  IrpOverflow = 0;
+  IrpPending  = 0;
+
+  for (RepeatStart = 0; RepeatStart < Program->OpTotal; ++RepeatStart)
+    if (Program->Op[RepeatStart].Type == IRP_OP_REPEAT) break;
+
+
+  for (Pass = 0; Pass <= Repeat; ++Pass)
+  {
+    if ((Pass > 0) && (RepeatStart >= Program->OpTotal)) break;  // no repeated part.
+
+    First        = (Pass == 0) ? 0 : (RepeatStart + 1);
+    Last         = (Pass == 0) ? RepeatStart : Program->OpTotal;
+    IrpFrameTime = 0;
+
+    for (Loop1UInt8 = First; Loop1UInt8 < Last; ++Loop1UInt8)
+    {
+      Op = &Program->Op[Loop1UInt8];
+
+      switch (Op->Type)
+      {
+        case (IRP_OP_DURATION):
+          irp_emit(Op->Value);
+        break;
+
+        case (IRP_OP_EXTENT):
+          if ((uint32_t)Op->Value > IrpFrameTime) irp_emit(-(int32_t)((uint32_t)Op->Value - IrpFrameTime));
+          IrpFrameTime = 0;
+        break;
+
+        case (IRP_OP_FIELD):
+          Value = Variable[Op->Variable];
+          if (Op->Invert) Value = ~Value;
+          irp_emit_bits(Program, Value >> Op->Shift, Op->Bits);
+        break;
+
+        case (IRP_OP_CONSTANT):
+          irp_emit_bits(Program, (uint32_t)Op->Value, Op->Bits);
+        break;
+      }
+    }
+  }
+
+  /* Last flash (the gap following it, if any, is not part of the burst). */
+  if (IrpPending > 0)
+  {
+    if (IrpOutCount < IrpOutSize) IrpOut[IrpOutCount++] = (uint32_t)abs(IrpPending);
+    else IrpOverflow = 1;
+  }
+
+  return (IrpOverflow) ? 0 : IrpOutCount;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=irp_expect() */
+/* ------------------------------------------------------------------ *\
+     Match an expected flash (> 0) or gap (< 0) against the durations
+      being decoded. A duration received longer than Longest may be
+     several durations of the same kind merged together: only the part
+       expected is consumed. Returns 0 when matched, 1 otherwise.
+\* ------------------------------------------------------------------ */
+static uint8_t irp_expect(int32_t Duration, uint32_t Longest)
+{
+  uint32_t Expected;
+  uint32_t Received;
+
+
+  if (IrpRemaining == 0)
+  {
+    /* The gap following the last flash of a burst is never received. */
+    if (IrpInIndex >= IrpInCount) return (Duration < 0) ? 0 : 1;
+
+    IrpRemaining = ((IrpInIndex % 2) == 0) ? (int32_t)IrpIn[IrpInIndex] : -(int32_t)IrpIn[IrpInIndex];
+    ++IrpInIndex;
+  }
+
+  if ((Duration > 0) != (IrpRemaining > 0)) return 1;
+
+  Expected      = (uint32_t)abs(Duration);
+  Received      = (uint32_t)abs(IrpRemaining);
+  IrpFrameTime += Expected;
+
+  if (((Received * 100) >= (Expected * (100 - IRP_TOLERANCE))) && ((Received * 100) <= (Expected * (100 + IRP_TOLERANCE))))
+  {
+    IrpRemaining = 0;
+    return 0;
+  }
+
+  if ((Received * 100) > (Longest * (100 + IRP_TOLERANCE)))
+  {
+    IrpRemaining -= Duration;
+    return 0;
+  }
+
+  return 1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=irp_items() */
+/* ------------------------------------------------------------------ *\
+     Compile the bare items following an opening parenthesis, up to
+     and including the closing one. Level 0 is the main list, level 1
+      the repeated part (which must be the last item of the main list).
+                       Returns 1 on error.
+\* ------------------------------------------------------------------ */
+static uint8_t irp_items(struct irp_program *Program, uint8_t Level)
+{
+  char *End;
+
+  struct irp_op *Op;
+
+
+  while (1)
+  {
+    irp_blanks();
+    if (*IrpCursor == ')')
+    {
+      ++IrpCursor;
+      return 0;
+    }
+
+    if (Program->OpTotal >= IRP_MAX_OPS) return 1;
+    Op = &Program->Op[Program->OpTotal];
+
+    if (*IrpCursor == '(')
+    {
+      /* Repeated part: (...)*, (...)+ or (...)n. */
+      if (Level) return 1;
+      ++IrpCursor;
+      Op->Type = IRP_OP_REPEAT;
+      ++Program->OpTotal;
+      if (irp_items(Program, 1)) return 1;
+      if ((*IrpCursor == '*') || (*IrpCursor == '+')) ++IrpCursor;
+      else while (isdigit((unsigned char)*IrpCursor)) ++IrpCursor;
+
+      irp_blanks();
+      if (*IrpCursor != ')') return 1;
+      continue;
+    }
+
+    if (*IrpCursor == '^')
+    {
+      /* Extent. */
+      ++IrpCursor;
+      if (irp_duration(Program, &Op->Value) || (Op->Value <= 0)) return 1;
+      Op->Type = IRP_OP_EXTENT;
+    }
+    else if ((*IrpCursor == '~') || isupper((unsigned char)*IrpCursor))
+    {
+      /* Field: [~]V:bits[:shift]. */
+      if (*IrpCursor == '~')
+      {
+        Op->Invert = 1;
+        ++IrpCursor;
+      }
+      if (!isupper((unsigned char)*IrpCursor)) return 1;
+      Op->Variable = (uint8_t)(*IrpCursor++ - 'A');
+
+      if (*IrpCursor++ != ':') return 1;
+      Op->Bits = (uint8_t)strtoul(IrpCursor, &End, 10);
+      if ((End == IrpCursor) || (Op->Bits == 0) || (Op->Bits > 32)) return 1;
+      IrpCursor = End;
+
+      if (*IrpCursor == ':')
+      {
+        ++IrpCursor;
+        Op->Shift = (uint8_t)strtoul(IrpCursor, &End, 10);
+        if ((End == IrpCursor) || ((Op->Shift + Op->Bits) > 32)) return 1;
+        IrpCursor = End;
+      }
+
+      Op->Type = IRP_OP_FIELD;
+      Program->VariableUsed |= (1ul << Op->Variable);
+    }
+    else
+    {
+      /* Constant (value:bits) or duration. */
+      Op->Value = (int32_t)strtol(IrpCursor, &End, 0);
+      if ((End != IrpCursor) && (*End == ':'))
+      {
+        IrpCursor = End + 1;
+        Op->Bits  = (uint8_t)strtoul(IrpCursor, &End, 10);
+        if ((End == IrpCursor) || (Op->Bits == 0) || (Op->Bits > 32)) return 1;
+        IrpCursor = End;
+        Op->Type  = IRP_OP_CONSTANT;
+      }
+      else
+      {
+        if (irp_duration(Program, &Op->Value)) return 1;
+        Op->Type = IRP_OP_DURATION;
+      }
+    }
+    ++Program->OpTotal;
+
+    irp_blanks();
+    if (*IrpCursor == ',') ++IrpCursor;
+    else if (*IrpCursor != ')') return 1;
+  }
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=irp_match_bits() */
+/* ------------------------------------------------------------------ *\
+     Decode Bits bits, trying the durations of bit 0 then those of
+       bit 1 for each of them. Returns 1 if none of them matches.
+      Only a duration longer than every duration of the bit spec may
+      be merged with the next item (such as the gap of the last bit
+                      followed by an extent).
+\* ------------------------------------------------------------------ */
+static uint8_t irp_match_bits(const struct irp_program *Program, uint8_t Bits, uint32_t *Value)
+{
+  uint8_t Bit;
+  uint8_t Loop1UInt8;
+  uint8_t Loop2UInt8;
+
+  uint16_t SavedIndex;
+
+  int32_t SavedRemaining;
+
+  uint32_t Longest;
+  uint32_t SavedTime;
+
+
+  Longest = 0;
+  for (Bit = 0; Bit < 2; ++Bit)
+    for (Loop2UInt8 = 0; Loop2UInt8 < Program->BitLength[Bit]; ++Loop2UInt8)
+      if ((uint32_t)abs(Program->Bit[Bit][Loop2UInt8]) > Longest) Longest = (uint32_t)abs(Program->Bit[Bit][Loop2UInt8]);
+
+  *Value = 0;
+  for (Loop1UInt8 = 0; Loop1UInt8 < Bits; ++Loop1UInt8)
+  {
+    SavedIndex     = IrpInIndex;
+    SavedRemaining = IrpRemaining;
+    SavedTime      = IrpFrameTime;
+
+    for (Bit = 0; Bit < 2; ++Bit)
+    {
+      IrpInIndex   = SavedIndex;
+      IrpRemaining = SavedRemaining;
+      IrpFrameTime = SavedTime;
+
+      for (Loop2UInt8 = 0; Loop2UInt8 < Program->BitLength[Bit]; ++Loop2UInt8)
+        if (irp_expect(Program->Bit[Bit][Loop2UInt8], Longest)) break;
+      if (Loop2UInt8 == Program->BitLength[Bit]) break;  // every duration of this bit matched.
+    }
+    if (Bit == 2) return 1;
+
+    if (Program->FlagMsb)
+      *Value = (*Value << 1) | Bit;
+    else
+      *Value |= (uint32_t)Bit << Loop1UInt8;
+  }
+
+  return 0;
+}
@@ -0,0 +1,82 @@
+/* ================================================================== *\
+   IrIrp.h
+   Pico-Remote-Analyzer IRP notation interpreter.
+
+   IRP notation is the format used by the infrared community to
+   describe a protocol in one line, for example NEC1:
+      {38.4k,564}<1,-1|1,-3>(16,-8,D:8,S:8,F:8,~F:8,1,^108m,(16,-4,1,^108m)*)
+
+   irp_compile() turns such a string into a small program (a list of
+   operations with every duration already converted to usec), that is
+   then interpreted by irp_encode() to build a timing stream from the
+   values of the variables, and by irp_decode() to extract the values
+   of the variables from a burst received.
+
+   Supported subset:
+   - general spec:   {carrier k, unit, msb | lsb}   (unit may end with 'p' for carrier periods).
+   - bit spec:       <bit 0 durations | bit 1 durations>, each bit beginning with a flash
+                     and ending with a gap (pulse distance / pulse width coding).
+   - bare items:     durations (negative = gap, suffix 'm' = msec, 'u' = usec, 'p' = periods,
+                     no suffix = units), extents (^duration), fields (V:bits or V:bits:shift,
+                     optionally complemented ~V:...), constants (value:bits) and one repeated
+                     part ((...)*, (...)+ or (...)n).
+   - parameter specs ([...]) and definitions ({...} after the bare items) are skipped:
+     every variable must be given when encoding.
+   Bi-phase (Manchester) bit specs and expressions are not supported.
+
+   Like IrEncode.c, this module only depends on the C standard library.
+
+   irp_compile(), irp_encode() and irp_decode() keep their working
+   state in file-scope statics (IrIrp.c): they are not reentrant. Only
+   one of them may run at a time, so a program must not be used from
+   two tasks at once (for example the FreeRTOS decode task and the
+   console), nor from an interrupt handler.
+\* ================================================================== */
+#ifndef IR_IRP_H
+#define IR_IRP_H
+
+#include <stdint.h>
+
+#define IRP_MAX_OPS            64   // maximum number of operations in a compiled program.
+#define IRP_MAX_BIT_DURATIONS   4   // maximum number of durations for one bit in the bit spec.
+#define IRP_TOLERANCE          25   // a duration received within this percentage of the expected one matches.
+#define IRP_VARIABLES          26   // variables are single letters A to Z.
+
+#define IRP_OP_DURATION         1   // flash (Value > 0) or gap (Value < 0), in usec.
+#define IRP_OP_EXTENT           2   // gap completing the frame to Value usec since its beginning.
+#define IRP_OP_FIELD            3   // Bits bits of Variable, starting at bit Shift (complemented if Invert).
+#define IRP_OP_CONSTANT         4   // Bits bits of Value.
+#define IRP_OP_REPEAT           5   // beginning of the repeated part (the rest of the program).
+
+struct irp_op
+{
+  uint8_t Type;                     // IRP_OP_xxx.
+  uint8_t Variable;                 // variable number (0 = A ... 25 = Z).
+  uint8_t Bits;                     // number of bits of a field or constant.
+  uint8_t Shift;                    // first bit of the variable used by a field.
+  uint8_t Invert;                   // field is complemented.
+  int32_t Value;                    // duration (in usec) or constant value.
+};
+
+struct irp_program
+{
+  uint32_t CarrierFrequency;                     // carrier frequency (in Hz).
+  float    Unit;                                 // time unit (in usec).
+  uint8_t  FlagMsb;                              // fields are sent most significant bit first.
+  uint8_t  BitLength[2];                         // number of durations of bit 0 and bit 1.
+  int32_t  Bit[2][IRP_MAX_BIT_DURATIONS];        // durations of bit 0 and bit 1 (in usec).
+  uint8_t  OpTotal;                              // number of operations.
+  struct irp_op Op[IRP_MAX_OPS];                 // operations of the program.
+  uint32_t VariableUsed;                         // bit n set when variable n is used by a field.
+};
+
+/* Compile an IRP string. Returns 0 on success, otherwise the position (from 1) of the error in Text. */
+uint16_t irp_compile(const char *Text, struct irp_program *Program);
+
+/* Decode a burst (durations alternating flash / gap, beginning with a flash). Returns 0 and the value of every variable on success, 1 otherwise. */
+uint8_t irp_decode(const struct irp_program *Program, const volatile uint32_t *Duration, uint16_t StepCount, uint32_t *Variable);
+
+/* Encode a burst from the value of every variable, with the repeated part sent Repeat times. Returns the number of durations, 0 if Size is too small. */
+uint16_t irp_encode(const struct irp_program *Program, const uint32_t *Variable, uint8_t Repeat, uint32_t *Duration, uint16_t Size);
+
+#endif  // IR_IRP_H
@@ -20,11 +20,25 @@
 \* ------------------------------------------------------------------ */
 #include "Memorex.h"
 
-#define NUMBER_OF_BITS             32  // number of bits in the infrared data stream.
-#define NUMBER_OF_STEPS            73  // normal count for total number of steps for this remote control unit.
-#define NUMBER_OF_WAKEUP_STEPS      2  // number of steps in the "get-ready" / "start bit" / "wake-up".
-#define SEPARATOR               10000  // a duration greater than 10000 usec is considered a separator.
-#define TRIGGER_POINT_0_1         750  // trigger point between a "0" bit and a "1" bit (shorter than 750 usec = 0  /  longer that 750 usec = 1)
+#define NUMBER_OF_BITS             MEMOREX_NUMBER_OF_BITS  // number of bits in the infrared data stream.
+#define NUMBER_OF_STEPS                                73  // normal count for total number of steps for this remote control unit.
+#define NUMBER_OF_WAKEUP_STEPS                          2  // number of steps in the "get-ready" / "start bit" / "wake-up".
+#define SEPARATOR                       MEMOREX_SEPARATOR  // a duration greater than 10000 usec is considered a separator.
+#define TRIGGER_POINT_0_1       MEMOREX_TRIGGER_POINT_0_1  // trigger point between a "0" bit and a "1" bit (shorter than 750 usec = 0  /  longer that 750 usec = 1)
+
+
+/* Protocol descriptor used by the generic decoder / encoder (translator mode, etc...). */
+struct ir_protocol IrProtocol = MEMOREX_PROTOCOL;
+
+
+/* Button names of this remote control, in the order of the decoder below (template for a bulk-learning session). */
+const UCHAR *ButtonTemplate[] =
+{
+  "Power", "CD door", "1", "2", "3", "4", "5", "6", "7", "8", "9", "0", "Over", "Mute",
+  "Stop", "Play / Pause", "Rewind / Down", "Fast forward / Up", "Volume up",
+  "Volume down", "Random / Down", "Repeat / Up", "Set / Memory / Clock", "Tuner", "CD",
+  "Time", "Display", NULL
+};
 
 
 UINT8 decode_ir_command(UINT8 *IrCommand)
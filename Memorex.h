@@ -1,2 +1,24 @@
+#ifndef MEMOREX_H
+#define MEMOREX_H
+
 #define IR_COMMAND_TO_EXECUTE 1
-/// #define IR_BUTTON_...
\ No newline at end of file
+/// #define IR_BUTTON_...
+
+/* Protocol parameters of this remote control, shared by Memorex.c (IrProtocol) and the encoder (IrProtocolTable in IrEncode.c). */
+#define MEMOREX_CARRIER_FREQUENCY       37900  // carrier frequency (in Hz).
+#define MEMOREX_HEADER_LOW               4450  // "get-ready" Low level (in usec).
+#define MEMOREX_HEADER_HIGH              4450  // "get-ready" High level (in usec).
+#define MEMOREX_BIT_LOW                   475  // Low level of every data bit (in usec).
+#define MEMOREX_ZERO_HIGH                 650  // High level of a "0" bit (in usec).
+#define MEMOREX_ONE_HIGH                 1750  // High level of a "1" bit (in usec).
+#define MEMOREX_NUMBER_OF_BITS             32  // number of bits in the infrared data stream.
+#define MEMOREX_ADDRESS_BITS               16  // number of address bits (first bits received).
+#define MEMOREX_COMMAND_BITS                8  // number of command bits (following the address bits, the rest being check bits).
+#define MEMOREX_TRIGGER_POINT_0_1         750  // trigger point between a "0" bit and a "1" bit (in usec).
+#define MEMOREX_SEPARATOR               10000  // a duration greater than this is a separator (in usec).
+
+/* Protocol descriptor initializer (see struct ir_protocol in IrEncode.h). */
+#define MEMOREX_PROTOCOL {"Memorex", MEMOREX_CARRIER_FREQUENCY, MEMOREX_HEADER_LOW, MEMOREX_HEADER_HIGH, MEMOREX_BIT_LOW, MEMOREX_ZERO_HIGH, MEMOREX_ONE_HIGH, \
+                         MEMOREX_NUMBER_OF_BITS, MEMOREX_ADDRESS_BITS, MEMOREX_COMMAND_BITS, MEMOREX_TRIGGER_POINT_0_1, MEMOREX_SEPARATOR}
+
+#endif  // MEMOREX_H
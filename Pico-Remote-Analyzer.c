@@ -22,11 +22,31 @@
                                                                                 Include files.
 \* ------------------------------------------------------------------------------------------------------------------------------------------------------------------- */
 #include "hardware/adc.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/pio.h"
+#include "hardware/pll.h"
+#include "hardware/xosc.h"
+#include "IrDatabase.h"
+#include "IrEncode.h"
+#include "IrEvent.h"
+#include "IrIrp.h"
+#include "IrCarrier.pio.h"
+#include "IrSampler.pio.h"
+#include "IrTransmit.pio.h"
 #include "pico/stdlib.h"
 #include "pico/unique_id.h"
+#include "math.h"
 #include "stdio.h"
 #include "stdlib.h"
 #include "string.h"
+#include "tusb.h"
+
+#ifdef USE_FREERTOS
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "task.h"
+#endif  // USE_FREERTOS
 
 
 
@@ -43,6 +63,8 @@ typedef unsigned char UCHAR;
 /* GPIO definitions. */
 #define UART_TX_PIN      0              // serial line to transmit data to   an external PC running a terminal emulation software.
 #define UART_RX_PIN      1              // serial line to receive  data from an external PC running a terminal emulation software.
+#define IR_CARRIER       20             // GPIO used for a raw (non-demodulating) photodiode receiver, to measure the carrier.
+#define IR_TX            21             // GPIO used for infrared LED tx (through a driver transistor).
 #define IR_RX            22             // GPIO used for VS1838b infrared sensor rx.
 #define PICO_LED         25             // on-board LED.
 #define BUZZER           27             // active buzzer on the Geeek Pico Base.
@@ -56,6 +78,122 @@ typedef unsigned char UCHAR;
 #define TYPE_PICO_W      2             // microcontroller is a Pico W
 #define REMOTE_FILENAME  "Samsung.c"
 
+/* Infrared transmitter definitions. */
+#define TRANSMIT_PIO              pio0   // PIO block used to generate the infrared carrier.
+#define TRANSMIT_CARRIER_DEFAULT  38000  // default carrier frequency (in Hz) when replaying a burst.
+#define TRANSMIT_MAX_PERIODS      65536  // maximum number of carrier periods for one Mark or one Space (16 bits in PIO program).
+#define TRANSMIT_GUARD_TIME        5000  // VS1838b keeps receiving our own infrared light for this long (in usec) after a transmission.
+
+/* Carrier measurement definitions. */
+#define CARRIER_PIO               pio0   // PIO block used to time carrier periods (shared with the transmitter).
+#define CARRIER_INVERTED             0   // set to 1 if the raw receiver output is Low while receiving infrared light.
+#define CARRIER_MAX_MARKS          128   // maximum number of Marks measured in one burst.
+#define CARRIER_GAP_TIME           100   // a Low level longer than this (in usec) on IR_CARRIER ends a Mark.
+#define CARRIER_END_TIME        150000   // measurement ends when no carrier has been received for this long (in usec).
+
+/* Multi-receiver capture definitions. */
+#define SAMPLER_PIO               pio1   // PIO block used to sample several infrared receivers at once.
+#define SAMPLER_PIN_BASE            10   // first of four consecutive GPIOs with an infrared receiver (GPIO 10 to 13).
+#define SAMPLER_CHANNELS             4   // number of infrared receivers sampled (1 to 4).
+#define SAMPLER_RATE           1000000   // default samples per second (one counter tick = 1 usec).
+#define SAMPLER_RATE_HIGH            0   // sample rate selecting full system clock speed (one tick = 10 cycles, 80 nsec at 125 MHz).
+#define SAMPLER_RING_BITS           12   // DMA ring buffer of 2^12 bytes (1024 words).
+#define SAMPLER_MAX_STEPS          256   // maximum number of steps kept for each receiver.
+
+/* Pre-trigger ring buffer definitions. */
+#define PRETRIGGER_EDGES          1024   // number of edges kept in the pre-trigger ring (before and after the start of a burst).
+#define PRETRIGGER_WINDOW          100   // default pre-trigger window (in msec).
+
+/* Frame segmentation definitions. */
+#define MAX_FRAMES                  16   // maximum number of frames kept for one burst.
+#define FRAME_NOISE                  0   // frame without "get-ready" bit (glitch, other remote control...).
+#define FRAME_DATA                   1   // complete frame decoded with the protocol descriptor.
+#define FRAME_REPEAT                 2   // same command as previous data frame, or short "get-ready" only repeat frame.
+#define FRAME_HEADER                 3   // "get-ready" bit followed by data that doesn't fit the protocol.
+
+/* Dormant (low-power) mode definitions. */
+#define DORMANT_AWAKE_TIMEOUT    250000  // go back to dormant if no complete burst after this delay (in usec) from wake-up.
+
+/* Event definitions (main loop sleeps until one of these events is posted). */
+#define EVENT_NONE                    0
+#define EVENT_BURST_COMPLETE          1  // nothing received from IR sensor for BURST_COMPLETE_TIME after last edge.
+#define EVENT_KEY_INPUT               2  // character(s) available on stdin.
+#define EVENT_TIMER                   3  // periodic event (every EVENT_TIMER_PERIOD).
+#define EVENT_USB_ATTACH              4  // USB CDC connection with PC terminal emulator software has been established.
+#define EVENT_IR_FRAME                5  // frame decoded and queued for the application while its queue was empty (see IrEvent.h).
+#define EVENT_QUEUE_SIZE             16  // number of events that may be pending.
+#define EVENT_TIMER_PERIOD      1000000  // period of EVENT_TIMER (in usec).
+#define BURST_COMPLETE_TIME      100000  // infrared burst is complete after this delay (in usec) without edge (longer than the gap between repeated frames).
+
+#ifdef USE_FREERTOS
+/* FreeRTOS-SMP build definitions. */
+#define RTOS_BURST_QUEUE_SIZE         2  // complete bursts waiting to be decoded.
+#define RTOS_DECODE_QUEUE_SIZE       16  // decoded bursts waiting to be displayed.
+#define RTOS_CAPTURE_PRIORITY  (configMAX_PRIORITIES - 1)
+#define RTOS_DECODE_PRIORITY   (tskIDLE_PRIORITY + 2)
+#define RTOS_CONSOLE_PRIORITY  (tskIDLE_PRIORITY + 1)
+#define RTOS_STACK_SIZE            1024  // stack size of each task (in words).
+#endif  // USE_FREERTOS
+
+/* Headless boot definitions. */
+#define HEADLESS_LOG_SIZE            32  // number of bursts kept while no console is attached (oldest ones are overwritten).
+#define HEADLESS_TONE_PERIOD    2500000  // period (in usec) of the short tone telling that no console is attached.
+
+/* Macro-command definitions. */
+#define MAX_MACROS                   16  // maximum number of macro-commands.
+#define MAX_MACRO_STEPS              16  // maximum number of commands in one macro-command.
+#define MACRO_IDLE                 0xFF  // no macro-command is being played.
+#define MACRO_RETRY_TIME            500  // check again after this delay (in usec) when the infrared transmitter is busy.
+
+/* Bulk-learning session definitions. */
+#define LEARN_MAX_NAMES              64  // maximum number of button names entered for a learning session.
+#define LEARN_MAX_ATTEMPTS            3  // number of times a button is asked again when both presses don't match.
+
+/* Recent captures / bit-level diff definitions. */
+#define RECENT_CAPTURES               8  // number of recent bursts kept for comparison.
+#define MAX_RECENT_STEPS            160  // maximum number of steps kept for each recent burst.
+#define DIFF_TOLERANCE               20  // two durations differing by more than this percentage are reported as changed.
+
+/* Timing-tolerance calibration definitions. */
+#define CAL_HEADER_LOW                0  // "get-ready" Low level.
+#define CAL_HEADER_HIGH               1  // "get-ready" High level.
+#define CAL_BIT_LOW                   2  // Low level of data bits.
+#define CAL_ZERO_HIGH                 3  // High level of "0" bits.
+#define CAL_ONE_HIGH                  4  // High level of "1" bits.
+#define CAL_GAP                       5  // High level between two frames.
+#define CALIBRATION_CLASSES           6  // number of duration classes above.
+#define CALIBRATION_MARGIN_PERCENT   10  // a threshold closer than this percentage to a measured duration is flagged.
+
+/* Waveform view definitions. */
+#define WAVEFORM_COLUMNS            100  // number of columns of each waveform strip.
+#define WAVEFORM_STRIPS               8  // number of waveform strips on one screen.
+
+/* Duration histogram definitions. */
+#define HISTOGRAM_BINS               44  // 4 bins per octave, from 64 usec to 131 msec.
+#define HISTOGRAM_FIRST_OCTAVE        6  // first bin begins at 2^6 = 64 usec.
+#define HISTOGRAM_BAR_WIDTH          50  // width (in characters) of the longest histogram bar.
+#define HISTOGRAM_RARE_PERCENT        2  // a cluster holding less than this percentage of durations is flagged.
+#define HISTOGRAM_MAX_BURSTS        200  // maximum number of bursts accumulated (keeps UINT16 bin counts from overflowing with full bursts).
+
+/* Timing profile definitions. */
+#define MAX_PROFILE_BURSTS          500  // maximum number of bursts accumulated in a timing profile.
+
+/* Raw learn / replay definitions (for bursts that can't be decoded). */
+#define MAX_RAW_BUTTONS              16  // maximum number of buttons learned raw.
+#define MAX_RAW_STEPS               256  // maximum number of steps kept for a button learned raw.
+#define RAW_GLITCH_TIME             100  // a step shorter than this (in usec) is a glitch merged with its neighbours.
+#define RAW_QUANTUM                  25  // raw durations are rounded to a multiple of this (in usec).
+
+/* Raw signature definitions (recognition of bursts that can't be decoded). */
+#define SIGNATURE_TABLE_SIZE         64  // number of slots in the signature hash table (must be a power of 2).
+#define SIGNATURE_PRESSES             3  // presses recorded for each button learned.
+#define SIGNATURE_CLUSTERS            8  // maximum number of distinct durations of each logic level in a frame.
+#define SIGNATURE_FNV_OFFSET 2166136261u // FNV-1a 32-bit offset basis.
+#define SIGNATURE_FNV_PRIME    16777619u // FNV-1a 32-bit prime.
+
+/* Protocol definitions. */
+#define PROTOCOL_TOLERANCE           25  // tolerance (in percent) on "get-ready" durations when decoding with a protocol descriptor.
+
 /* Debug flag definitions. */
 #define DEBUG_NONE       0x0000000000000000
 #define DEBUG_IR_COMMAND 0x0000000000000001
@@ -70,6 +208,34 @@ volatile UINT64 IrInitialValue[MAX_IR_READINGS];  // initial timer value when re
 volatile UCHAR  IrLevel[MAX_IR_READINGS];         // logic levels of remote control signal: 'L' (low), 'H' (high), or 'X' (undefined).
 volatile UINT32 IrResultValue[MAX_IR_READINGS];   // duration of this logic level (Low or High) in the signal received from remote control.
 volatile UINT16 IrStepCount;                      // number of "logic level changes" received from IR remote control in current stream.
+volatile UINT64 IrReceiveMaskEnd;                 // edges are ignored until this timer value (while we are transmitting ourself).
+volatile UINT16 IrFrameStart;                     // step where current frame begins (after last separator).
+
+/* Pre-trigger ring: every edge received, whatever the state of the capture arrays above. */
+struct
+{
+  UINT32 Time;                                    // timer value of the edge (in usec, 32 bits).
+  UINT8  Level;                                   // logic level following the edge (0 = Low, 1 = High).
+} volatile PretriggerRing[PRETRIGGER_EDGES];
+volatile UINT32 PretriggerHead;                   // number of edges written to the ring so far.
+volatile UINT32 PretriggerTrigger;                // ring edge number of the first edge of last burst (0xFFFFFFFF if none).
+UINT16 PretriggerWindow;                          // pre-trigger window (in msec).
+UINT32 PretriggerCopied;                          // trigger edge of the burst whose pre-trigger edges have been copied to the main capture.
+
+/* Frame of a burst, split on idle gaps (see segment_burst()). Every caller holds its own array of MAX_FRAMES frames. */
+struct burst_frame
+{
+  UINT16 Start;                                   // first step of the frame (always a Low level).
+  UINT16 StepCount;                               // number of steps in the frame (idle gap excluded).
+  UINT8  Type;                                    // FRAME_NOISE, FRAME_DATA, FRAME_REPEAT or FRAME_HEADER.
+  UINT8  FlagDecoded;                             // Code is valid.
+  UINT64 Code;                                    // command decoded from this frame.
+};
+UINT32 SegmentGap;                                // a High level longer than this (in usec) ends a frame.
+
+/* Protocol defined at runtime in IRP notation (see IrIrp.h). */
+struct irp_program IrpProgram;                    // compiled IRP string.
+UCHAR  IrpString[130];                            // IRP string entered (empty if none).
 
 UCHAR BrandName[128];       // brand of the remote control being analyzed.
 UCHAR ButtonName[64];       // identify the remote control button being analyzed.
@@ -89,47 +255,429 @@ struct
 } RemoteData[256];
 UINT16 RemoteDataTotal;
 
+/* Infrared transmitter. */
+UINT32 TransmitBuffer[(MAX_IR_READINGS / 2) + 1];  // Mark / Space pairs (in carrier periods) fed to the PIO state machine by DMA.
+UINT32 TransmitCarrier;                             // carrier frequency (in Hz) currently programmed in the PIO state machine.
+UINT   TransmitDmaChannel;                          // DMA channel feeding the PIO state machine.
+UINT64 TransmitEndTime;                             // timer value when the burst currently being sent will be completed.
+UINT64 TransmitStartTime;                           // timer value when the burst currently being sent has been started.
+UINT   TransmitStateMachine;                        // PIO state machine generating the infrared carrier.
+
+/* Translator (receive remote control A, transmit remote control B). */
+struct
+{
+  UINT64 SourceId;  // command decoded from remote control being received.
+  UINT64 TargetId;  // command sent on behalf of remote control being emulated.
+  const struct ir_protocol *TargetProtocol;  // protocol of remote control being emulated.
+} TranslateTable[MAX_BUTTONS];
+UINT16 TranslateTotal;
+
+/* Central event queue (posted from interrupt context, consumed by main loop). */
+volatile UINT8 EventHead;                     // next free slot in EventQueue.
+volatile UINT8 EventQueue[EVENT_QUEUE_SIZE];
+volatile UINT8 EventTail;                     // next event to be consumed.
+repeating_timer_t EventTimer;                 // periodic timer posting EVENT_TIMER and EVENT_USB_ATTACH.
+volatile alarm_id_t BurstAlarmId;             // alarm posting EVENT_BURST_COMPLETE (re-armed on every infrared edge).
+
+#ifdef USE_FREERTOS
+/* FreeRTOS-SMP build: messages exchanged between tasks. */
+struct burst_message
+{
+  UINT64 Time;                           // timer value of the first edge of the burst.
+  UINT16 StepCount;                      // number of steps in the burst.
+  UINT32 Duration[MAX_IR_READINGS];      // duration of every step (in usec).
+};
+
+struct decode_message
+{
+  UINT64 Time;                           // timer value of the first edge of the burst.
+  UINT64 Code;                           // command decoded (if FlagDecoded is On).
+  UINT32 DecodeTime;                     // time spent decoding (in usec).
+  UINT16 StepCount;                      // number of steps in the burst.
+  UINT8  FlagDecoded;                    // burst has been decoded with the protocol descriptor.
+};
+
+QueueHandle_t BurstQueue;                // capture task -> decode task.
+QueueHandle_t DecodeQueue;               // decode task  -> console task.
+TaskHandle_t  CaptureTaskHandle;
+TaskHandle_t  ConsoleTaskHandle;
+TaskHandle_t  DecodeTaskHandle;
+UINT32        BurstDropCount;            // bursts dropped because decode task was lagging behind.
+#endif  // USE_FREERTOS
+
+/* Bursts received while no console is attached (headless boot). */
+struct
+{
+  UINT64 Time;                // timer value of the first edge of the burst.
+  UINT64 Code;                // command decoded (if FlagDecoded is On).
+  UINT16 StepCount;           // number of steps in the burst.
+  UINT8  FlagDecoded;         // burst has been decoded with the protocol descriptor.
+} HeadlessLog[HEADLESS_LOG_SIZE];
+UINT32 HeadlessLogTotal;      // number of bursts received while headless (may be more than HEADLESS_LOG_SIZE).
+UINT64 CaptureArmedTime;      // timer value when infrared capture has been armed after boot.
+
+/* Macro-commands (one button received triggers a sequence of commands sent). */
+struct
+{
+  UINT64 TriggerId;            // command received that starts this macro-command.
+  UINT8  StepTotal;            // number of commands in this macro-command.
+  struct
+  {
+    UINT64 CommandId;          // command to send.
+    UINT8  Repeat;             // number of times this command is sent.
+    UINT16 Delay;              // delay (in msec) after each transmission of this command.
+  } Step[MAX_MACRO_STEPS];
+} Macro[MAX_MACROS];
+UINT8 MacroTotal;
+
+volatile UINT8 MacroActive;    // macro-command being played (MACRO_IDLE if none).
+UINT8  MacroRepeat;            // number of times current command has been sent so far.
+UINT8  MacroStep;              // command being sent in the macro-command being played.
+UINT32 MacroDuration[(MAX_IR_READINGS / 2) + 1];  // Mark / Space durations of the command being sent.
+
+/* Most recent bursts received for analysis (for bit-level diff). */
+struct
+{
+  UCHAR  ButtonName[64];              // button name, entered after the burst has been received (empty if none).
+  UINT64 Code;                        // command decoded (if FlagDecoded is On).
+  UINT8  FlagDecoded;                 // burst has been decoded with the protocol descriptor.
+  UINT16 StepCount;                   // number of steps kept in Duration.
+  UINT16 Duration[MAX_RECENT_STEPS];  // duration of every step (in usec, saturated to 65535).
+} RecentCapture[RECENT_CAPTURES];
+UINT32 RecentTotal;                   // number of bursts received for analysis so far.
+
+/* Log-scale histogram of durations, one for Low levels (marks) and one for High levels (spaces). */
+UINT16 Histogram[2][HISTOGRAM_BINS];     // number of durations in each bin.
+UINT32 HistogramSum[2][HISTOGRAM_BINS];  // sum of durations in each bin (to compute cluster mean).
+UINT32 HistogramTotal[2];                // number of durations in each histogram.
+
+/* Carrier measured on every Mark of last burst (raw photodiode receiver on IR_CARRIER). */
+struct
+{
+  UINT16 Periods;             // number of carrier periods in this Mark.
+  UINT32 Frequency;           // carrier frequency (in Hz).
+  UINT16 Duty;                // duty cycle (in tenths of percent).
+} CarrierMark[CARRIER_MAX_MARKS];
+UINT16 CarrierMarkTotal;      // number of Marks measured in last burst.
+UINT32 CarrierMeasured;       // average carrier frequency of last measurement (in Hz, 0 if never measured).
+UINT   CarrierOffset;         // offset of carrier measurement program in PIO memory.
+UINT   CarrierStateMachine;   // PIO state machine timing carrier periods.
+
+/* Multi-receiver capture: DMA ring buffer filled by the sampler state machine, and edge stream of every receiver. */
+UINT32 SamplerRing[1 << (SAMPLER_RING_BITS - 2)] __attribute__((aligned(1 << SAMPLER_RING_BITS)));
+UINT   SamplerDmaChannel;     // DMA channel copying sampler words into the ring buffer.
+UINT   SamplerOffset;         // offset of sampler program in PIO memory.
+UINT   SamplerStateMachine;   // PIO state machine sampling the receivers.
+float  SamplerTick;           // duration of one counter tick (in nsec), every sampler duration is in counter ticks.
+struct
+{
+  UINT8  FlagStarted;                   // first edge has been received on this receiver.
+  UINT64 FirstEdge;                     // time of first edge (in counter ticks from the start of the capture).
+  UINT64 LastEdge;                      // time of last edge (in counter ticks from the start of the capture).
+  UINT16 StepCount;                     // number of steps received.
+  UINT32 Duration[SAMPLER_MAX_STEPS];   // duration of every step (in counter ticks).
+} SamplerChannel[SAMPLER_CHANNELS];
+
+/* Timing-tolerance calibration: range of every duration class measured over many bursts. */
+struct
+{
+  UINT32 Count;               // number of durations in this class.
+  UINT32 Min;                 // shortest duration (in usec).
+  UINT32 Max;                 // longest  duration (in usec).
+} Calibration[CALIBRATION_CLASSES];
+
+/* Timing profile: streaming (Welford) statistics of every step over many presses of the same button. */
+struct
+{
+  UINT16 Count;               // number of bursts having this step.
+  float  Mean;                // running mean duration (in usec).
+  float  M2;                  // running sum of squared differences from the mean.
+  UINT32 Min;                 // shortest duration (in usec).
+  UINT32 Max;                 // longest  duration (in usec).
+} Profile[MAX_IR_READINGS];
+
+/* Buttons learned raw (normalized timing, for protocols that can't be decoded). */
+struct
+{
+  UCHAR  ButtonName[64];
+  UINT32 CarrierFrequency;           // carrier frequency (in Hz) used to replay this button.
+  UINT16 StepCount;                  // number of steps in Duration.
+  UINT32 Duration[MAX_RAW_STEPS];    // normalized Mark / Space durations (in usec), beginning with a Mark.
+} RawData[MAX_RAW_BUTTONS];
+UINT8 RawDataTotal;
+
+/* Hash table of raw signatures learned (open addressing, a Signature of 0 is an empty slot). */
+struct
+{
+  UINT32 Signature;                  // signature of the first frame (see signature_compute()).
+  UCHAR  ButtonName[32];             // button learned with this signature.
+} SignatureTable[SIGNATURE_TABLE_SIZE];
+UINT8 SignatureTotal;                // number of slots used in SignatureTable.
+
+/* Protocol descriptor of the remote control file (see REMOTE_FILENAME). */
+extern struct ir_protocol IrProtocol;
+extern const UCHAR *ButtonTemplate[];  // button names of the remote control (NULL-terminated).
+
 
 
 /* ------------------------------------------------------------------------------------------------------------------------------------------------------------------- *\
                                                                              Function prototypes.
 \* ------------------------------------------------------------------------------------------------------------------------------------------------------------------- */
+/* Alarm callback posting EVENT_BURST_COMPLETE when the infrared line has been idle for BURST_COMPLETE_TIME. */
+int64_t burst_callback(alarm_id_t AlarmId, void *UserData);
+
+/* Tell if an infrared burst has been received and the line has been idle for BURST_COMPLETE_TIME since its last edge. */
+UINT8 burst_complete(void);
+
+/* Add the durations of last infrared burst to the calibration classes. */
+void calibrate_add(void);
+
+/* Display calibration report of the protocol descriptor thresholds. */
+void calibrate_report(void);
+
+/* Display one threshold of the calibration report. Returns 1 if the threshold is close to (or beyond) a measured duration. */
+UINT8 calibrate_threshold(UCHAR *Name, UINT32 Current, UINT32 Lower, UINT32 Upper);
+
+/* Accumulate bursts from a remote control and calibrate the protocol descriptor thresholds. */
+void calibrate_timing(void);
+
+/* Initialize the PIO state machine measuring carrier periods on IR_CARRIER. */
+void carrier_init(void);
+
+/* Measure carrier frequency and duty cycle of every Mark of next burst. */
+void carrier_measure(void);
+
+#ifdef USE_FREERTOS
+/* FreeRTOS task copying every complete burst out of the capture arrays (highest priority, core 0). */
+void capture_task(void *Param);
+
+/* FreeRTOS task displaying decoded bursts and task run time statistics (core 1). */
+void console_task(void *Param);
+#endif  // USE_FREERTOS
+
+/* Display the brand, device and function of every database entry matching a command. */
+UINT16 database_display(UINT64 Code);
+
+/* Find the first database entry matching a command (binary search). */
+UINT32 database_find(UINT64 Code, UINT16 *Count);
+
 /* Decode last infrared burst received. */
 void decode_ir_burst(UCHAR FlagAskButton);
 
 /* Decode last infrared burst received using current remote filename. */
 UINT8 decode_ir_command(UINT8 *IrCommand);
 
+/* Decode an infrared frame silently, using the protocol descriptor. */
+UINT8 decode_ir_data(volatile UINT32 *Duration, UINT16 StepCount, UINT64 *Code);
+
+#ifdef USE_FREERTOS
+/* FreeRTOS task decoding bursts received from capture task (core 1). */
+void decode_task(void *Param);
+#endif  // USE_FREERTOS
+
+/* Display two commands bit by bit, flagging the bits that differ. */
+void diff_bits(UINT64 CodeA, UINT64 CodeB);
+
+/* Compare two recent captures, bit by bit and step by step. */
+void diff_captures(UINT8 IndexA, UINT8 IndexB);
+
+/* Find constant (address) and variable (command) bit fields across the whole button list. */
+void diff_fields(void);
+
+/* Bit-level diff sub-menu. */
+void diff_menu(void);
+
 /* Display the infrared burst timing information. */
 void display_burst_timing(UINT8 FlagAskButton);
 
 /* Display complete list of buttons decoded. */
 void display_button_list(void);
 
+/* Display frames decoded by the capture pipeline, as an application would receive them. */
+void display_events(void);
+
 /* Display header for burst timing information. */
 void display_header(void);
 
+/* Low-power receiver mode, sleeping dormant between infrared bursts. */
+void dormant_mode(void);
+
+/* Stop all clocks until the infrared sensor line goes Low, then restart them. Returns the time (in usec) taken by the clock restart. */
+UINT32 dormant_sleep(void);
+
+/* Post an event to the central event queue (may be called from interrupt context). */
+void event_post(UINT8 Event);
+
+/* Periodic timer callback posting EVENT_TIMER (and EVENT_USB_ATTACH when USB CDC connection is established). */
+bool event_timer_callback(repeating_timer_t *Timer);
+
+/* Sleep until an event is available in the central event queue and return it. */
+UINT8 event_wait(void);
+
+/* Build the Mark / Space durations of an infrared frame from a command, using the protocol descriptor. */
+UINT16 encode_ir_frame(UINT64 Code, UINT32 *Duration);
+
 /* Assign brand name and serial number to the remote control. */
 void enter_remote_id(void);
 
 /* Determine if the microcontroller is a Pico or a Pico W and retrieve its Unique Number. */
 UINT8 get_pico_id(void);
 
+/* Capture and log infrared bursts until a console is attached. */
+void headless_capture(void);
+
+/* Add the durations of last infrared burst to the duration histograms. */
+void histogram_add(void);
+
+/* Return the lower bound (in usec) of a histogram bin. */
+UINT32 histogram_bin_floor(UINT8 Bin);
+
+/* Display duration histograms and their clusters. */
+void histogram_display(void);
+
+/* Build duration histograms from one or many infrared bursts. */
+void histogram_menu(void);
+
 /* Initialize variables that will receive next infrared data burst. */
 void init_burst_variables(void);
 
 /* Read a string from stdin. */
 void input_string(UCHAR *String);
 
+/* IRP notation sub-menu: define a protocol at runtime, decode and send with it. */
+void irp_menu(void);
+
 /* Interrupt handler for signal received from IR sensor. */
 gpio_irq_callback_t isr_signal_trap(UINT8 gpio, UINT32 Events);
 
+/* Callback posting EVENT_KEY_INPUT when characters are available on stdin. */
+void key_callback(void *Param);
+
+/* Wait for next infrared burst during a learning session and decode it. */
+UINT8 learn_capture(UINT64 *Code, int16_t *Key);
+
+/* Guided bulk-learning session for a whole remote control. */
+void learn_session(void);
+
+/* Timer callback sending the commands of the macro-command being played. */
+int64_t macro_callback(alarm_id_t AlarmId, void *UserData);
+
+/* Macro-command sub-menu. */
+void macro_menu(void);
+
+/* Start playing a macro-command in background. */
+UINT8 macro_start(UINT8 MacroNumber);
+
+/* Prepend the edges of the pre-trigger window to the main capture. */
+void pretrigger_copy(void);
+
+/* Display the edges received during the pre-trigger window preceding last burst. */
+void pretrigger_display(void);
+
+/* Find the ring edges of the pre-trigger window preceding last burst. */
+UINT8 pretrigger_find(UINT32 *First, UINT32 *Trigger);
+
+/* Pre-trigger ring buffer sub-menu. */
+void pretrigger_menu(void);
+
+/* Accumulate many presses of the same button and display statistics of every step. */
+void profile_timing(void);
+
+/* Add the durations of last infrared burst to the timing profile. */
+void profile_update(void);
+
+/* Learn last infrared burst received as raw timing. */
+void raw_learn(void);
+
+/* Raw learn / replay sub-menu. */
+void raw_menu(void);
+
+/* Remove glitches from a burst and quantize its durations. */
+UINT16 raw_normalize(volatile UINT32 *Source, UINT16 StepCount, UINT32 *Target);
+
+/* Keep a copy of last infrared burst in the recent captures. */
+void recent_capture_add(void);
+
+/* Give a name to the most recent capture. */
+void recent_capture_name(UCHAR *Name);
+
+/* Replay last infrared burst received through the infrared transmitter. */
+void replay_ir_burst(void);
+
+#ifdef USE_FREERTOS
+/* Create FreeRTOS queues and tasks, and start the scheduler (never returns). */
+void rtos_start(void);
+#endif  // USE_FREERTOS
+
+/* Capture next burst on every infrared receiver at once. */
+void sampler_capture(void);
+
+/* Copy the edge stream of one receiver into the main capture arrays, scaled to usec. */
+void sampler_copy(UINT8 Channel);
+
+/* Display the edge streams of every infrared receiver side by side. */
+void sampler_display(void);
+
+/* Initialize the PIO state machine and DMA channel sampling several infrared receivers. */
+void sampler_init(void);
+
+/* Change the sample rate (counter tick) of the multi-receiver capture. */
+void sampler_set_rate(UINT32 Rate);
+
+/* Split a burst into frames on idle gaps and label every frame. */
+UINT8 segment_burst(volatile UINT32 *Duration, UINT16 StepCount, struct burst_frame *Frame);
+
+/* Segment a burst and return the command of its first data frame. */
+UINT8 segment_decode(volatile UINT32 *Duration, UINT16 StepCount, UINT64 *Code);
+
+/* Display the frames of last infrared burst. */
+void segment_display(void);
+
+/* Frame segmentation sub-menu. */
+void segment_menu(void);
+
+/* Reduce the first frame of a burst to a 32-bit signature (quantized durations, hashed). */
+UINT32 signature_compute(volatile UINT32 *Duration, UINT16 StepCount);
+
+/* Find a signature in the signature hash table. */
+int16_t signature_find(UINT32 Signature);
+
+/* Add a signature and its button name to the signature hash table. */
+UINT8 signature_learn(UINT32 Signature, UCHAR *ButtonName);
+
+/* Raw signature sub-menu (learn and recognize buttons of any protocol). */
+void signature_menu(void);
+
 /* Make a tone for the specified number of milliseconds on active buzzer. */
 void tone(UINT16 MilliSeconds);
 
+/* Translator sub-menu. */
+void translate_menu(void);
+
+/* Translate infrared bursts from one remote control to another until a key is pressed. */
+void translate_run(void);
+
+/* Send a list of Mark / Space durations through the infrared transmitter. */
+UINT8 transmit_burst(volatile UINT32 *Duration, UINT16 StepCount, UINT32 CarrierFrequency);
+
+/* Tell if the infrared transmitter is still sending a burst. */
+UINT8 transmit_busy(void);
+
+/* Encode and send a command from protocol name, address and command. */
+void transmit_command(void);
+
+/* Initialize the PIO state machine and DMA channel of the infrared transmitter. */
+void transmit_init(void);
+
 /* Send a string to external monitor through Pico UART (or USB CDC). */
 void uart_send(UINT16 LineNumber, UCHAR *String);
 
+/* Render last infrared burst as a time-scaled waveform, starting at Start usec with Scale usec per column. */
+void waveform_draw(UINT32 Start, UINT32 Scale);
+
+/* Waveform view of last infrared burst, with zoom and pan. */
+void waveform_view(void);
+
 
 
 /* $PAGE */
@@ -144,9 +692,13 @@ int main(void)
   UINT8 FlagAskButton;
   UINT8 IrCommand;
 
+  int16_t Slot;
+
   UINT Loop1UInt;
   UINT Menu;
 
+  UINT32 Signature;
+
 
   /* Debug items. */
   DebugBitMask  = DEBUG_NONE;
@@ -156,6 +708,20 @@ int main(void)
   /* Initializations. */
   IrStepCount     = 0;  // number of "logic level changes" in the infrared burst.
   RemoteDataTotal = 0;  // number of buttons already decoded on remote unit.
+  TranslateTotal  = 0;  // number of entries in translation table.
+  MacroTotal      = 0;  // number of macro-commands defined.
+  MacroActive     = MACRO_IDLE;
+  RawDataTotal    = 0;  // number of buttons learned raw.
+  SignatureTotal  = 0;  // number of raw signatures learned.
+  memset(SignatureTable, 0x00, sizeof(SignatureTable));
+  RecentTotal     = 0;  // number of bursts received for analysis.
+  PretriggerHead    = 0;           // pre-trigger ring is empty.
+  PretriggerTrigger = 0xFFFFFFFF;  // no burst received yet.
+  PretriggerWindow  = PRETRIGGER_WINDOW;
+  PretriggerCopied  = 0xFFFFFFFF;  // nothing copied yet.
+  SegmentGap        = IrProtocol.Separator;
+  IrpString[0]      = 0x00;  // no protocol defined in IRP notation yet.
+  IrReceiveMaskEnd = 0ll;
   strcpy(LevelString[0], "low");
   strcpy(LevelString[1], "high");
   strcpy(LevelString[2], "---");
@@ -194,21 +760,41 @@ int main(void)
   gpio_set_dir(IR_RX, GPIO_IN);
   gpio_pull_up(IR_RX);  // Line will remain at high level until a signal is received.
 
+  /* Central event queue and its producers (other than the infrared ISR below). */
+  EventHead    = 0;
+  EventTail    = 0;
+  BurstAlarmId = 0;
+  add_repeating_timer_us(-EVENT_TIMER_PERIOD, event_timer_callback, NULL, &EventTimer);
+  stdio_set_chars_available_callback(key_callback, NULL);
+
+  /* Initialize the interrupt service routine (ISR) used to time-tag the infrared burst.
+     Capture is armed right away, without waiting for a console to be attached. */
+  init_burst_variables();
+  gpio_set_irq_enabled_with_callback(IR_RX, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true, (gpio_irq_callback_t)&isr_signal_trap);
+  CaptureArmedTime = time_us_64();
+
+  /* Initialize infrared transmitter (PIO state machine generating the carrier and DMA channel feeding it). */
+  transmit_init();
+
+  /* Initialize carrier measurement (PIO state machine timing carrier periods from a raw photodiode receiver). */
+  carrier_init();
+
+  /* Initialize multi-receiver capture (PIO state machine sampling up to four receivers, DMA channel feeding a ring buffer). */
+  sampler_init();
+
 
   /* Determine microcontroller type (Pico or Pico W) and Pico's Unique ID ("serial number"). */
   get_pico_id();
 
 
-  /* Wait for a valid connection with the PC terminal emulator software (USB CDC). */
-  while (!stdio_usb_connected())
-  {
-    tone(25);
-    sleep_ms(2500);
-  }
-  
+#ifdef USE_FREERTOS
+  /* FreeRTOS-SMP build: capture, decode and console tasks take over from here. */
+  rtos_start();
+#endif  // USE_FREERTOS
 
-  /* Initialize the interrupt service routine (ISR) used to time-tag the infrared burst. */
-  gpio_set_irq_enabled_with_callback(IR_RX, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true, (gpio_irq_callback_t)&isr_signal_trap);
+
+  /* Keep capturing (and logging) infrared bursts until the PC terminal emulator software is connected. */
+  headless_capture();
 
 
   /* Confirm / enter remote control brand and model number on entry. */
@@ -229,10 +815,23 @@ int main(void)
     printf("Current step count is: %u\r\r\r", IrStepCount);
     printf("Press a button on remote control for analysis: ");
     
-    /* Wait until a button has been pressed on remote control. */
-    while (IrStepCount == 0) sleep_ms(250);
+    /* Sleep until a complete burst has been received from remote control. */
+    while (burst_complete() == 0) event_wait();
     printf("\r\r\r");
-    sleep_ms(250);  // make sure infrared data burst has been completed.
+    recent_capture_add();
+
+    /* Name the probable brand, device and function of the command from the offline code database. */
+    if (RecentCapture[(RecentTotal - 1) % RECENT_CAPTURES].FlagDecoded)
+    {
+      if (database_display(RecentCapture[(RecentTotal - 1) % RECENT_CAPTURES].Code)) printf("\r");
+    }
+    else if (SignatureTotal)
+    {
+      /* Burst doesn't fit the protocol: recognize it from the raw signatures learned. */
+      Signature = signature_compute(IrResultValue, IrStepCount);
+      Slot      = signature_find(Signature);
+      printf("Raw signature 0x%8.8lX: %s\r\r", Signature, (Slot < 0) ? "unknown" : (char *)SignatureTable[Slot].ButtonName);
+    }
 
     display_header();
 
@@ -245,6 +844,25 @@ int main(void)
     printf("     2) Display infrared burst timing.\r");
     printf("     3) Decode this infrared burst using file %s\r", REMOTE_FILENAME);
     printf("     4) Display complete remote control button list.\r");
+    printf("     5) Replay this infrared burst through infrared transmitter.\r");
+    printf("     6) Translator mode (receive remote control A, transmit remote control B).\r");
+    printf("     7) Macro-commands (one button triggers a sequence of commands).\r");
+    printf("     8) Raw learn / replay (for infrared bursts that can't be decoded).\r");
+    printf("     9) Dormant low-power receiver mode (console on UART only).\r");
+    printf("    10) Display decoded frames as delivered to an application.\r");
+    printf("    11) Timing profile over many presses of the same button.\r");
+    printf("    12) Duration histogram and clusters.\r");
+    printf("    13) Bit-level diff between captures / buttons.\r");
+    printf("    14) Guided learning session for a whole remote control.\r");
+    printf("    15) Timing-tolerance calibration report.\r");
+    printf("    16) Waveform view of last infrared burst.\r");
+    printf("    17) Carrier frequency and duty cycle measurement.\r");
+    printf("    18) Multi-receiver capture.\r");
+    printf("    19) Pre-trigger window (edges received before last burst).\r");
+    printf("    20) Frames of last burst (idle-gap segmentation).\r");
+    printf("    21) Send a command (protocol, address, command).\r");
+    printf("    22) Protocol defined in IRP notation.\r");
+    printf("    23) Raw signatures (recognize buttons of any protocol).\r");
     printf("\r");
 
     printf("        Enter an option: ");
@@ -283,6 +901,138 @@ int main(void)
         printf("\r\r");
       break;
 
+      case (5):
+        /* Send back last infrared burst received. */
+        printf("\r\r");
+        replay_ir_burst();
+        printf("\r\r");
+      break;
+
+      case (6):
+        /* Translate one remote control to another. */
+        printf("\r\r");
+        translate_menu();
+        printf("\r\r");
+      break;
+
+      case (7):
+        /* Define macro-commands. */
+        printf("\r\r");
+        macro_menu();
+        printf("\r\r");
+      break;
+
+      case (8):
+        /* Learn / replay raw infrared bursts. */
+        printf("\r\r");
+        raw_menu();
+        printf("\r\r");
+      break;
+
+      case (9):
+        /* Low-power receiver, waking up on infrared bursts. */
+        printf("\r\r");
+        dormant_mode();
+        printf("\r\r");
+      break;
+
+      case (10):
+        /* Application interface demo. */
+        printf("\r\r");
+        display_events();
+        printf("\r\r");
+      break;
+
+      case (11):
+        /* Statistics of every step over many presses. */
+        printf("\r\r");
+        profile_timing();
+        printf("\r\r");
+      break;
+
+      case (12):
+        /* Log-scale histogram of durations. */
+        printf("\r\r");
+        histogram_menu();
+        printf("\r\r");
+      break;
+
+      case (13):
+        /* Compare captures to find address and command bits. */
+        printf("\r\r");
+        diff_menu();
+        printf("\r\r");
+      break;
+
+      case (14):
+        /* Learn every button of a remote control in one session. */
+        printf("\r\r");
+        learn_session();
+        printf("\r\r");
+      break;
+
+      case (15):
+        /* Margins between measured durations and protocol thresholds. */
+        printf("\r\r");
+        calibrate_timing();
+        printf("\r\r");
+      break;
+
+      case (16):
+        /* Time-scaled waveform on VT100 terminal. */
+        waveform_view();
+        printf("\r\r");
+      break;
+
+      case (17):
+        /* Raw photodiode receiver on IR_CARRIER. */
+        printf("\r\r");
+        carrier_measure();
+        printf("\r\r");
+      break;
+
+      case (18):
+        /* Up to four receivers sampled by the same PIO state machine. */
+        printf("\r\r");
+        sampler_capture();
+        printf("\r\r");
+      break;
+
+      case (19):
+        /* Edges kept in the pre-trigger ring. */
+        printf("\r\r");
+        pretrigger_menu();
+        printf("\r\r");
+      break;
+
+      case (20):
+        /* Split last burst into frames. */
+        printf("\r\r");
+        segment_menu();
+        printf("\r\r");
+      break;
+
+      case (21):
+        /* Encode a frame from its fields and send it. */
+        printf("\r\r");
+        transmit_command();
+        printf("\r\r");
+      break;
+
+      case (22):
+        /* Define a protocol at runtime in IRP notation. */
+        printf("\r\r");
+        irp_menu();
+        printf("\r\r");
+      break;
+
+      case (23):
+        /* Learn and recognize buttons whose protocol can't be decoded. */
+        printf("\r\r");
+        signature_menu();
+        printf("\r\r");
+      break;
+
       default:
         printf("\r\r");
         printf("           Invalid choice... please re-enter [%s]  [%u]\r\r\r\r\r", String, Menu);
@@ -297,82 +1047,142 @@ int main(void)
 
 
 /* $PAGE */
-/* $TITLE=decode_ir_command() */
+/* $TITLE=burst_callback() */
 /* ------------------------------------------------------------------ *\
-                 Decode last infrared burst received.
+       Alarm callback posting EVENT_BURST_COMPLETE when the infrared
+         line has been idle for BURST_COMPLETE_TIME (the alarm is
+                 re-armed by the ISR on every edge).
 \* ------------------------------------------------------------------ */
-#include REMOTE_FILENAME
+int64_t burst_callback(alarm_id_t AlarmId, void *UserData)
+{
+#ifdef USE_FREERTOS
+  BaseType_t FlagWoken;
+#endif  // USE_FREERTOS
+
+
+  BurstAlarmId = 0;
+  event_post(EVENT_BURST_COMPLETE);
+
+#ifdef USE_FREERTOS
+  /* Wake up capture task. */
+  if (CaptureTaskHandle != NULL)
+  {
+    FlagWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(CaptureTaskHandle, &FlagWoken);
+    portYIELD_FROM_ISR(FlagWoken);
+  }
+#endif  // USE_FREERTOS
+
+  return 0;  // one-shot alarm.
+}
 
 
 
 
 
 /* $PAGE */
-/* $TITLE=decode_ir_burst() */
+/* $TITLE=burst_complete() */
 /* ------------------------------------------------------------------ *\
-                 Decode last infrared burst received.
+      Tell if an infrared burst has been received and the line has
+     been idle for BURST_COMPLETE_TIME since its last edge. Waiters
+     check this state instead of relying on EVENT_BURST_COMPLETE only:
+     the event may have been consumed by another event_wait() caller
+     (input_string() for instance) or be left over from a previous
+       burst while a new one is in progress. Since EVENT_TIMER is
+       posted periodically, a waiter never sleeps for more than
+           EVENT_TIMER_PERIOD past the end of the burst.
 \* ------------------------------------------------------------------ */
-void decode_ir_burst(UINT8 FlagAskButton)
+UINT8 burst_complete(void)
 {
-  UCHAR String[256];
+  UINT16 StepCount;
 
-  UINT8 IrCommand;
-  UINT8 LineCount;
+  UINT32 InterruptState;
 
-  UINT16 Loop1UInt16;
+  UINT64 LastEdge;
 
-  
-  /* Initializations. */
-  LineCount = 50;  // number of lines per page.
 
+  /* Step count and start of current level must come from the same edge. */
+  InterruptState = save_and_disable_interrupts();
+  StepCount = IrStepCount;
+  LastEdge  = IrInitialValue[StepCount];
+  restore_interrupts(InterruptState);
 
-  if (IrStepCount == 0)
-  {
-    printf("No infrared burst has been received yet...\r");
-    printf("You must first press a button on the remote control before selecting this menu choice.\r\r");
-    printf("Press <Enter> to return to menu: ");
+  if (StepCount == 0) return 0;
 
-    input_string(String);
+  return ((time_us_64() - LastEdge) >= BURST_COMPLETE_TIME);
+}
 
-    return;
-  }
 
 
-  if (FlagAskButton)
-  {
-    printf("Enter button name for this infrared burst: ");
-    input_string(ButtonName);
-  }
-  
 
-  display_burst_timing(FLAG_OFF);  // first, display infrared burst timing.
-  decode_ir_command(&IrCommand);   // then, display decoded data.
 
-  /*** Optionally display buttons already decoded so far. ***
-  display_header();
+/* $PAGE */
+/* $TITLE=calibrate_add() */
+/* ------------------------------------------------------------------ *\
+     Add the durations of last infrared burst to the calibration
+     classes. Durations are classified by their position in the frame
+      and by the nominal values of the protocol descriptor (never by
+         the thresholds being calibrated).
+\* ------------------------------------------------------------------ */
+void calibrate_add(void)
+{
+  UINT8 Class;
 
-  printf("\r");
-  printf("Number of buttons decoded: %u\r\r", RemoteDataTotal);
-  printf("        Remote control             Infrared command\r");
-  printf("           button name                      decoded\r\r");
+  UINT16 BitCount;
+  UINT16 Loop1UInt16;
 
-  for (Loop1UInt16 = 0; Loop1UInt16 < MAX_BUTTONS; ++Loop1UInt16)
+  UINT32 High;
+  UINT32 Low;
+
+
+  BitCount = IrProtocol.NumberOfBits;  // no frame started yet.
+
+  for (Loop1UInt16 = 0; (Loop1UInt16 + 1) < IrStepCount; Loop1UInt16 += 2)
   {
-    printf("[%3u] %16s                   0x%8.8llX\r", Loop1UInt16, RemoteData[Loop1UInt16].ButtonName, RemoteData[Loop1UInt16].CommandId);
-    if (((Loop1UInt16 % LineCount) == 0) && (Loop1UInt16 != 0))
+    Low  = IrResultValue[Loop1UInt16];
+    High = IrResultValue[Loop1UInt16 + 1];
+
+    if (Low > ((IrProtocol.HeaderLow + IrProtocol.BitLow) / 2))
     {
-      printf("\r");
-      printf("to be continued...\r");
-      printf("%s\r\r\r", Separator);
-      display_header();
-      printf("\r");
-      printf("Number of buttons decoded: %u\r\r", RemoteDataTotal);
-      printf("        Remote control             Infrared command\r");
-      printf("           button name                      decoded\r\r");
+      /* "Get-ready" bit. */
+      Class    = CAL_HEADER_LOW;
+      BitCount = 0;
+    }
+    else
+    {
+      Class = CAL_BIT_LOW;
+    }
+
+    ++Calibration[Class].Count;
+    if (Low < Calibration[Class].Min) Calibration[Class].Min = Low;
+    if (Low > Calibration[Class].Max) Calibration[Class].Max = Low;
+
+    if (Class == CAL_HEADER_LOW)
+    {
+      Class = CAL_HEADER_HIGH;
     }
+    else if (BitCount < IrProtocol.NumberOfBits)
+    {
+      Class = (High > ((IrProtocol.ZeroHigh + IrProtocol.OneHigh) / 2)) ? CAL_ONE_HIGH : CAL_ZERO_HIGH;
+      ++BitCount;
+    }
+    else
+    {
+      /* High level following the stop bit. */
+      Class = CAL_GAP;
+    }
+
+    /* A High level much longer than the "get-ready" High level interrupts the frame. */
+    if ((Class != CAL_GAP) && (High > (IrProtocol.HeaderHigh * 2)))
+    {
+      Class    = CAL_GAP;
+      BitCount = IrProtocol.NumberOfBits;
+    }
+
+    ++Calibration[Class].Count;
+    if (High < Calibration[Class].Min) Calibration[Class].Min = High;
+    if (High > Calibration[Class].Max) Calibration[Class].Max = High;
   }
-  printf("%s\r\r\r", Separator);
-  ***/
 
   return;
 }
@@ -382,128 +1192,356 @@ void decode_ir_burst(UINT8 FlagAskButton)
 
 
 /* $PAGE */
-/* $TITLE=display_burst_timing() */
+/* $TITLE=calibrate_report() */
 /* ------------------------------------------------------------------ *\
-            Display the infrared burst timing information.
+      Display the range of every duration class, then the margin
+     between the measured durations and every threshold used by the
+        decoder, along with the threshold maximizing this margin.
 \* ------------------------------------------------------------------ */
-void display_burst_timing(UINT8 FlagAskButton)
+void calibrate_report(void)
 {
-  UCHAR Dum1UChar[128];
-  UCHAR String[128];
-
-  UINT16 CurrentHiCount;
-  UINT16 Loop1UInt16;
-  UINT16 Loop2UInt16;
-  UINT16 LineCount;
+  UCHAR *ClassName[CALIBRATION_CLASSES] = {"Get-ready Low", "Get-ready High", "Bit Low", "Bit 0 High", "Bit 1 High", "Gap between frames"};
 
+  UINT8 FlagClose;
+  UINT8 Loop1UInt8;
 
-  /* Initializations. */
-  LineCount = 50;  // number of lines per page.
+  UINT32 Lower;
+  UINT32 Upper;
 
 
-  if (IrStepCount == 0)
+  display_header();
+  printf("Calibration of protocol %s\r\r", IrProtocol.Name);
+  printf("     Duration class      Count      Min      Max\r\r");
+  for (Loop1UInt8 = 0; Loop1UInt8 < CALIBRATION_CLASSES; ++Loop1UInt8)
   {
-    printf("No infrared burst has been received yet...\r");
-    printf("You must first press a button on the remote control before selecting this menu choice.\r\r");
-    printf("Press <Enter> to return to menu: ");
-
-    input_string(String);
+    if (Calibration[Loop1UInt8].Count)
+      printf("%19s     %6lu    %5lu    %5lu\r", ClassName[Loop1UInt8], Calibration[Loop1UInt8].Count, Calibration[Loop1UInt8].Min, Calibration[Loop1UInt8].Max);
+    else
+      printf("%19s     %6lu      ---      ---\r", ClassName[Loop1UInt8], 0);
+  }
+  printf("\r");
 
+  if ((Calibration[CAL_HEADER_LOW].Count == 0) || (Calibration[CAL_BIT_LOW].Count == 0) || (Calibration[CAL_ZERO_HIGH].Count == 0) || (Calibration[CAL_ONE_HIGH].Count == 0))
+  {
+    printf("Not enough frames of protocol %s to calibrate thresholds.\r", IrProtocol.Name);
+    printf("%s\r\r", Separator);
     return;
   }
 
 
-  if (FlagAskButton)
+  printf("          Threshold    Current   Margin   Recommended   Margin\r\r");
+  FlagClose = FLAG_OFF;
+
+  /* "Get-ready" Low level window (PROTOCOL_TOLERANCE). */
+  FlagClose |= calibrate_threshold("Get-ready min", (IrProtocol.HeaderLow * (100 - PROTOCOL_TOLERANCE)) / 100, Calibration[CAL_BIT_LOW].Max, Calibration[CAL_HEADER_LOW].Min);
+  FlagClose |= calibrate_threshold("Get-ready max", (IrProtocol.HeaderLow * (100 + PROTOCOL_TOLERANCE)) / 100, Calibration[CAL_HEADER_LOW].Max, 0);
+
+  /* TRIGGER_POINT_0_1: every bit Low level and "0" High level must be below it, every "1" High level above it. */
+  Lower = (Calibration[CAL_ZERO_HIGH].Max > Calibration[CAL_BIT_LOW].Max) ? Calibration[CAL_ZERO_HIGH].Max : Calibration[CAL_BIT_LOW].Max;
+  FlagClose |= calibrate_threshold("TRIGGER_POINT_0_1", IrProtocol.TriggerPoint01, Lower, Calibration[CAL_ONE_HIGH].Min);
+
+  /* SEPARATOR: every High level inside a frame must be below it, every gap between frames above it. */
+  Lower = Calibration[CAL_ONE_HIGH].Max;
+  if (Calibration[CAL_ZERO_HIGH].Max   > Lower) Lower = Calibration[CAL_ZERO_HIGH].Max;
+  if (Calibration[CAL_HEADER_HIGH].Max > Lower) Lower = Calibration[CAL_HEADER_HIGH].Max;
+  Upper = (Calibration[CAL_GAP].Count) ? Calibration[CAL_GAP].Min : 0;
+  FlagClose |= calibrate_threshold("SEPARATOR", IrProtocol.Separator, Lower, Upper);
+
+  printf("\r");
+  if (FlagClose)
+    printf("*** This remote control sits close to a decision boundary of protocol %s (less than %u%% margin).\r", IrProtocol.Name, CALIBRATION_MARGIN_PERCENT);
+  else
+    printf("Every threshold of protocol %s keeps at least %u%% margin with this remote control.\r", IrProtocol.Name, CALIBRATION_MARGIN_PERCENT);
+  printf("%s\r\r", Separator);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=calibrate_threshold() */
+/* ------------------------------------------------------------------ *\
+     Display one threshold of the calibration report. Lower is the
+      longest duration that must remain below the threshold, Upper is
+     the shortest duration that must remain above it (0 if there is
+     no upper limit). The recommended threshold is the middle of both,
+     which maximizes the margin. Returns 1 if current threshold is
+       closer than CALIBRATION_MARGIN_PERCENT to a measured duration.
+\* ------------------------------------------------------------------ */
+UINT8 calibrate_threshold(UCHAR *Name, UINT32 Current, UINT32 Lower, UINT32 Upper)
+{
+  int32_t Margin;
+  int32_t RecommendedMargin;
+
+  UINT32 Recommended;
+
+
+  if (Upper)
   {
-    printf("Enter button name for this infrared burst: ");
-    input_string(ButtonName);
+    Margin            = (((int32_t)Current - (int32_t)Lower) < ((int32_t)Upper - (int32_t)Current)) ? ((int32_t)Current - (int32_t)Lower) : ((int32_t)Upper - (int32_t)Current);
+    Recommended       = (Lower + Upper) / 2;
+    RecommendedMargin = ((int32_t)Upper - (int32_t)Lower) / 2;
   }
-  
-
-  for (Loop1UInt16 = 0; Loop1UInt16 < IrStepCount; Loop1UInt16 += (LineCount * 2))
+  else
   {
-    printf("\r\r\r\r\r");
-    display_header();
+    Margin            = (int32_t)Current - (int32_t)Lower;
+    Recommended       = (Lower * (100 + (2 * CALIBRATION_MARGIN_PERCENT))) / 100;
+    RecommendedMargin = (int32_t)Recommended - (int32_t)Lower;
+  }
 
-    /* Display Button name. */
-    printf("Button: %s\r\r", ButtonName);
+  printf("%19s      %5lu   %6ld         %5lu   %6ld   ", Name, Current, Margin, Recommended, RecommendedMargin);
+  if (Margin < 0)
+    printf("*** misdecodes\r");
+  else if ((Margin * 100) < (int32_t)(Current * CALIBRATION_MARGIN_PERCENT))
+    printf("*** close to boundary\r");
+  else
+    printf("ok\r");
 
-    /* Display timing for every logic level change of last received infrared burst. */
-    printf(" Step      Logic    Duration                     Step      Logic    Duration\r");
-    printf("number     level                                number     level\r\r");
+  return ((Margin * 100) < (int32_t)(Current * CALIBRATION_MARGIN_PERCENT)) ? 1 : 0;
+}
 
-    for (Loop2UInt16 = Loop1UInt16; Loop2UInt16 < (Loop1UInt16 + LineCount); ++Loop2UInt16)
-    {
-      printf("  %3u       %4s      %5lu", Loop2UInt16 + 1, LevelString[IrLevel[Loop2UInt16]], IrResultValue[Loop2UInt16]);
 
-      if (IrStepCount > (Loop2UInt16 + LineCount))
-      {
-        printf("                       %3u       %4s      %5lu", Loop2UInt16 + LineCount + 1, LevelString[IrLevel[Loop2UInt16 + LineCount]], IrResultValue[Loop2UInt16 + LineCount]);
-      }
-      printf("\r");
 
-      if (Loop2UInt16 == IrStepCount)
+
+
+/* $PAGE */
+/* $TITLE=calibrate_timing() */
+/* ------------------------------------------------------------------ *\
+     Accumulate bursts from any buttons of a remote control, then
+       display the calibration report of the protocol thresholds.
+\* ------------------------------------------------------------------ */
+void calibrate_timing(void)
+{
+  UINT8 FlagStop;
+  UINT8 Loop1UInt8;
+
+  UINT16 BurstCount;
+
+
+  for (Loop1UInt8 = 0; Loop1UInt8 < CALIBRATION_CLASSES; ++Loop1UInt8)
+  {
+    Calibration[Loop1UInt8].Count = 0;
+    Calibration[Loop1UInt8].Min   = 0xFFFFFFFF;
+    Calibration[Loop1UInt8].Max   = 0;
+  }
+
+  printf("Press as many different buttons as possible (a few times each), then any key on the console to display the report.\r\r");
+  for (BurstCount = 0; ; ++BurstCount)
+  {
+    init_burst_variables();
+    FlagStop = FLAG_OFF;
+    while (burst_complete() == 0)
+    {
+      event_wait();
+      if (getchar_timeout_us(0) != PICO_ERROR_TIMEOUT)
       {
-        printf("\r");
-        printf("%s", Separator);
-        break;  // get out of "for" loop when all steps have been displayed.
+        FlagStop = FLAG_ON;
+        break;
       }
     }
+    if (FlagStop) break;
 
-    if (IrStepCount > (Loop1UInt16 + (LineCount * 2)))
-    {
-      printf("\r");
-      printf("to be continued\r");
-    }
-    printf("%s", Separator);
+    calibrate_add();
+    printf("Burst %3u: %3u steps\r", BurstCount + 1, IrStepCount);
   }
+  printf("\r\r");
+
+  calibrate_report();
 
   return;
 }
- 
+
 
 
 
 
 /* $PAGE */
-/* $TITLE=display_button_list() */
+/* $TITLE=carrier_init() */
 /* ------------------------------------------------------------------ *\
-               Display complete list of buttons decoded.
+     Initialize the PIO state machine timing carrier periods from a
+       raw (non-demodulating) photodiode receiver on IR_CARRIER. The
+      state machine remains disabled until a measurement is started.
 \* ------------------------------------------------------------------ */
-void display_button_list(void)
+void carrier_init(void)
 {
-  UINT8  LineCount;
+  CarrierMarkTotal    = 0;
+  CarrierMeasured     = 0;
+  CarrierOffset       = pio_add_program(CARRIER_PIO, &ir_carrier_program);
+  CarrierStateMachine = pio_claim_unused_sm(CARRIER_PIO, true);
+  ir_carrier_program_init(CARRIER_PIO, CarrierStateMachine, CarrierOffset, IR_CARRIER);
+
+  if (CARRIER_INVERTED) gpio_set_inover(IR_CARRIER, GPIO_OVERRIDE_INVERT);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=carrier_measure() */
+/* ------------------------------------------------------------------ *\
+     Measure carrier frequency and duty cycle of every Mark of next
+     burst, while the same burst is captured from the VS1838b, then
+       display both side by side. Carrier periods are timed by the
+     PIO state machine at full system clock speed (8 nsec at 125 MHz)
+        and the FIFO is emptied by polling until the burst is over.
+     Every word is tagged with its level: a High word whose Low word
+       has been dropped (FIFO full) is discarded instead of being
+                   paired with the next Low word.
+\* ------------------------------------------------------------------ */
+void carrier_measure(void)
+{
+  UINT8 FlagHigh;
 
   UINT16 Loop1UInt16;
+  UINT16 Lost;
+  UINT16 Periods;
+
+  UINT32 Cycles;
+  UINT32 GapCycles;
+  UINT32 High;
+  UINT32 SystemClock;
+  UINT32 Word;
+
+  UINT64 HighCycles;
+  UINT64 LastWordTime;
+  UINT64 PeriodCycles;
+  UINT64 TotalCycles;
+  UINT64 TotalPeriods;
 
 
   /* Initializations. */
-  LineCount = 50;
+  SystemClock      = clock_get_hz(clk_sys);
+  GapCycles        = (SystemClock / 1000000) * CARRIER_GAP_TIME;
+  CarrierMarkTotal = 0;
+  FlagHigh         = FLAG_OFF;
+  High             = 0;
+  HighCycles       = 0ll;
+  LastWordTime     = 0ll;
+  Lost             = 0;
+  PeriodCycles     = 0ll;
+  Periods          = 0;
+
+
+  printf("Raw photodiode receiver expected on GPIO %u.\r", IR_CARRIER);
+  printf("Press a button on the remote control (or any key on the console to cancel)...\r\r");
+
+  /* Restart the state machine from the top of its program. */
+  pio_sm_set_enabled(CARRIER_PIO, CarrierStateMachine, false);
+  pio_sm_clear_fifos(CARRIER_PIO, CarrierStateMachine);
+  pio_sm_restart(CARRIER_PIO, CarrierStateMachine);
+  pio_sm_exec(CARRIER_PIO, CarrierStateMachine, pio_encode_jmp(CarrierOffset));
+  init_burst_variables();
+  pio_sm_set_enabled(CARRIER_PIO, CarrierStateMachine, true);
+
+  while (1)
+  {
+    if (pio_sm_is_rx_fifo_empty(CARRIER_PIO, CarrierStateMachine))
+    {
+      /* Burst is over when no carrier has been received for a while (the Low word of the last period never comes). */
+      if (LastWordTime && ((time_us_64() - LastWordTime) > CARRIER_END_TIME)) break;
+      if ((LastWordTime == 0ll) && (getchar_timeout_us(0) != PICO_ERROR_TIMEOUT)) break;
+      continue;
+    }
+
+    Word         = pio_sm_get(CARRIER_PIO, CarrierStateMachine);
+    Cycles       = ((Word >> 1) * ir_carrier_CYCLES_PER_LOOP) + ir_carrier_CYCLES_EXTRA;
+    LastWordTime = time_us_64();
+
+    if (Word & 0x01)
+    {
+      /* High word. If the previous one was High too, the Low word in-between has been dropped. */
+      if (FlagHigh) ++Lost;
+      High     = Cycles;
+      FlagHigh = FLAG_ON;
+      continue;
+    }
+
+    if (FlagHigh == FLAG_OFF)
+    {
+      /* Low word whose High word has been dropped: ignore this period, but still detect the end of a Mark. */
+      ++Lost;
+      if (Cycles < GapCycles) continue;
+    }
+    FlagHigh = FLAG_OFF;
+
+    if (Cycles < GapCycles)
+    {
+      /* Complete carrier period inside a Mark. */
+      ++Periods;
+      PeriodCycles += High + Cycles;
+      HighCycles   += High;
+      continue;
+    }
 
+    /* Long Low level: the Mark ended with this (incomplete) period. */
+    if (CarrierMarkTotal < CARRIER_MAX_MARKS)
+    {
+      CarrierMark[CarrierMarkTotal].Periods   = Periods + 1;
+      CarrierMark[CarrierMarkTotal].Frequency = (PeriodCycles) ? (UINT32)(((UINT64)SystemClock * Periods) / PeriodCycles) : 0;
+      CarrierMark[CarrierMarkTotal].Duty      = (PeriodCycles) ? (UINT16)((HighCycles * 1000ll) / PeriodCycles) : 0;
+      ++CarrierMarkTotal;
+    }
+    Periods      = 0;
+    PeriodCycles = 0ll;
+    HighCycles   = 0ll;
+  }
+  pio_sm_set_enabled(CARRIER_PIO, CarrierStateMachine, false);
+
+  /* Last Mark of the burst. */
+  if (FlagHigh && (CarrierMarkTotal < CARRIER_MAX_MARKS))
+  {
+    CarrierMark[CarrierMarkTotal].Periods   = Periods + 1;
+    CarrierMark[CarrierMarkTotal].Frequency = (PeriodCycles) ? (UINT32)(((UINT64)SystemClock * Periods) / PeriodCycles) : 0;
+    CarrierMark[CarrierMarkTotal].Duty      = (PeriodCycles) ? (UINT16)((HighCycles * 1000ll) / PeriodCycles) : 0;
+    ++CarrierMarkTotal;
+  }
+
+  if (CarrierMarkTotal == 0)
+  {
+    printf("No carrier received on GPIO %u.\r\r", IR_CARRIER);
+    return;
+  }
 
+
+  /* Display carrier of every Mark alongside the timing received from VS1838b. */
   display_header();
-  printf("\r");
-  printf("Number of buttons decoded: %u\r\r", RemoteDataTotal);
-  printf("        Remote control             Infrared command\r");
-  printf("           button name                      decoded\r\r");
+  printf("Carrier measured on GPIO %u for button: %s\r\r", IR_CARRIER, ButtonName);
+  printf(" Mark    Step   VS1838b Low   Carrier    Duration   Frequency    Duty\r");
+  printf("number  number    (usec)      periods     (usec)       (Hz)      cycle\r\r");
 
-  for (Loop1UInt16 = 0; Loop1UInt16 < RemoteDataTotal; ++Loop1UInt16)
+  TotalCycles  = 0ll;
+  TotalPeriods = 0ll;
+  for (Loop1UInt16 = 0; Loop1UInt16 < CarrierMarkTotal; ++Loop1UInt16)
   {
-    printf("[%3u] %16s                   0x%8.8llX\r", Loop1UInt16, RemoteData[Loop1UInt16].ButtonName, RemoteData[Loop1UInt16].CommandId);
-    
-    if (((Loop1UInt16 % LineCount) == 0) && (Loop1UInt16 != 0))
+    printf(" %3u     %3u     ", Loop1UInt16, Loop1UInt16 * 2);
+    if ((Loop1UInt16 * 2) < IrStepCount)
+      printf("  %5lu ", IrResultValue[Loop1UInt16 * 2]);
+    else
+      printf("    --- ");
+    printf("      %5u      %5lu      %6lu    %3u.%1u%%\r", CarrierMark[Loop1UInt16].Periods, (CarrierMark[Loop1UInt16].Frequency) ? (UINT32)((CarrierMark[Loop1UInt16].Periods * 1000000ll) / CarrierMark[Loop1UInt16].Frequency) : 0, CarrierMark[Loop1UInt16].Frequency, CarrierMark[Loop1UInt16].Duty / 10, CarrierMark[Loop1UInt16].Duty % 10);
+
+    /* Average frequency, weighted by the number of periods of every Mark. */
+    if (CarrierMark[Loop1UInt16].Frequency)
     {
-      printf("\r");
-      printf("to be continued...\r");
-      printf("%s\r\r\r", Separator);
-      display_header();
-      printf("\r");
-      printf("Number of buttons decoded: %u\r\r", RemoteDataTotal);
-      printf("        Remote control             Infrared command\r");
-      printf("           button name                      decoded\r\r");
+      TotalCycles  += ((UINT64)(CarrierMark[Loop1UInt16].Periods - 1) * SystemClock) / CarrierMark[Loop1UInt16].Frequency;
+      TotalPeriods += CarrierMark[Loop1UInt16].Periods - 1;
     }
   }
-  printf("%s\r\r\r", Separator);
+
+  if (TotalCycles)
+  {
+    CarrierMeasured = (UINT32)((TotalPeriods * SystemClock) / TotalCycles);
+    printf("\r");
+    printf("Average carrier: %lu Hz over %llu periods (protocol %s: %lu Hz). Used from now on to replay bursts and learn raw.\r", CarrierMeasured, TotalPeriods, IrProtocol.Name, IrProtocol.CarrierFrequency);
+  }
+  if (Lost) printf("%u words dropped by the state machine (FIFO full): the periods concerned have been left out.\r", Lost);
+  printf("%s\r\r", Separator);
 
   return;
 }
@@ -512,62 +1550,49 @@ void display_button_list(void)
 
 
 
+#ifdef USE_FREERTOS
 /* $PAGE */
-/* $TITLE=display_header() */
+/* $TITLE=capture_task() */
 /* ------------------------------------------------------------------ *\
-              Display header for burst timing information.
+       FreeRTOS task (highest priority, core 0 where the infrared ISR
+       runs). Woken up by burst_callback() when a burst is complete,
+        it copies the burst out of the capture arrays, re-arms them
+               and hands the burst over to the decode task.
+      The notification is only a hint: the burst is checked complete
+     with burst_complete(), and the check, the copy and the re-arming
+     are done with interrupts disabled, so that an edge of a new burst
+                can't be mixed into the burst being copied.
 \* ------------------------------------------------------------------ */
-void display_header(void)
+void capture_task(void *Param)
 {
-  UCHAR String[128];
+  static struct burst_message Message;  // too big for task stack.
 
   UINT16 Loop1UInt16;
 
+  UINT32 InterruptState;
 
-  printf("%s", Separator);
-  
-
-  sprintf(String, "Flash-Remote-Analyzer\r");
-  for (Loop1UInt16 = 0; Loop1UInt16 < ((strlen(Separator) - strlen(String)) / 2); ++Loop1UInt16)
-    printf(" ");
-  printf("%s", String);
-  
-
-  sprintf(String, "Microcontroller is a ");
-  if (PicoType == TYPE_PICO)
-    sprintf(&String[strlen(String)], "Pico\r");
-  else
-    sprintf(&String[strlen(String)], "Pico W\r");
-  for (Loop1UInt16 = 0; Loop1UInt16 < ((strlen(Separator) - strlen(String)) / 2); ++Loop1UInt16)
-    printf(" ");
-  printf("%s", String);
-  
-
-  sprintf(String, "Pico's Unique ID: %s\r", PicoUniqueId);
-  for (Loop1UInt16 = 0; Loop1UInt16 < ((strlen(Separator) - strlen(String)) / 2); ++Loop1UInt16)
-    printf(" ");
-  printf("%s", String);
-  
-
-  sprintf(String, "Brand under analysis: %s\r", BrandName);
-  for (Loop1UInt16 = 0; Loop1UInt16 < ((strlen(Separator) - strlen(String)) / 2); ++Loop1UInt16)
-    printf(" ");
-  printf("%s", String);
-
-
-  sprintf(String, "Remote control model number: %s\r", RemoteModel);
-  for (Loop1UInt16 = 0; Loop1UInt16 < ((strlen(Separator) - strlen(String)) / 2); ++Loop1UInt16)
-    printf(" ");
-  printf("%s", String);
 
+  while (1)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-  sprintf(String, "Step count: %u\r", IrStepCount);
-  for (Loop1UInt16 = 0; Loop1UInt16 < ((strlen(Separator) - strlen(String)) / 2); ++Loop1UInt16)
-    printf(" ");
-  printf("%s", String);
+    InterruptState = save_and_disable_interrupts();
+    if (burst_complete() == 0)
+    {
+      /* Left over from a previous burst, or a new burst is already in progress (its own alarm will notify again). */
+      restore_interrupts(InterruptState);
+      continue;
+    }
 
+    Message.StepCount = IrStepCount;
+    Message.Time      = IrInitialValue[0];
+    for (Loop1UInt16 = 0; Loop1UInt16 < Message.StepCount; ++Loop1UInt16)
+      Message.Duration[Loop1UInt16] = IrResultValue[Loop1UInt16];
+    init_burst_variables();
+    restore_interrupts(InterruptState);
 
-  printf("%s", Separator);
+    if (xQueueSend(BurstQueue, &Message, 0) != pdTRUE) ++BurstDropCount;
+  }
 }
 
 
@@ -575,29 +1600,3970 @@ void display_header(void)
 
 
 /* $PAGE */
-/* $TITLE=enter_remote_id() */
+/* $TITLE=console_task() */
 /* ------------------------------------------------------------------ *\
-        Assign brand name and serial number to the remote control.
+       FreeRTOS task (lowest priority, core 1) displaying decoded
+      bursts, and task run time statistics when <s> is pressed.
 \* ------------------------------------------------------------------ */
-void enter_remote_id(void)
+void console_task(void *Param)
 {
-  UCHAR Dum1UChar[64];
+  UCHAR String[1024];
+
+  int DataInput;
+
+  struct decode_message Message;
 
 
-  printf("Current remote control brand is %s\r", BrandName);
-  printf("Enter the brand if it must be different: ");
-  input_string(Dum1UChar);
-  if ((Dum1UChar[0] != 0x00) && (Dum1UChar[0] != 0x0D))
-    strcpy(BrandName, Dum1UChar);
   printf("\r\r");
+  printf("Pico-Remote-Analyzer - FreeRTOS-SMP build (protocol %s).\r", IrProtocol.Name);
+  printf("Press <s> to display task run time statistics.\r\r");
+
+  while (1)
+  {
+    if (xQueueReceive(DecodeQueue, &Message, pdMS_TO_TICKS(100)) == pdTRUE)
+    {
+      if (Message.FlagDecoded)
+        printf("[%12llu] 0x%8.8llX   %3u steps   decoded in %4lu usec\r", Message.Time, Message.Code, Message.StepCount, Message.DecodeTime);
+      else
+        printf("[%12llu] undecoded burst   %3u steps\r", Message.Time, Message.StepCount);
+    }
+
+    while ((DataInput = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT)
+    {
+      if ((DataInput == 's') || (DataInput == 'S'))
+      {
+        vTaskGetRunTimeStats(String);
+        printf("\r");
+        printf("Task            Abs time (usec)   %% time\r");
+        printf("%s", String);
+        printf("Bursts dropped (decode task lagging behind): %lu\r", BurstDropCount);
+        printf("%s\r\r", Separator);
+      }
+    }
+  }
+}
+#endif  // USE_FREERTOS
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=database_display() */
+/* ------------------------------------------------------------------ *\
+     Display the brand, device type and function name of every entry
+      of the offline code database matching a command. Returns the
+                       number of entries found.
+\* ------------------------------------------------------------------ */
+UINT16 database_display(UINT64 Code)
+{
+  UINT16 Count;
+  UINT16 Loop1UInt16;
+
+  UINT32 Index;
+
+  const struct ir_database_entry *Entry;
+
+
+  Index = database_find(Code, &Count);
+
+  for (Loop1UInt16 = 0; Loop1UInt16 < Count; ++Loop1UInt16)
+  {
+    Entry = &IrDatabase[Index + Loop1UInt16];
+    printf("Code database: 0x%8.8lX   %-16s %-12s <%s>\r", Entry->Code, IrDatabaseDevice[Entry->Device].Brand, IrDatabaseDevice[Entry->Device].Type, IrDatabaseFunction[Entry->Function]);
+  }
+
+  return Count;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=database_find() */
+/* ------------------------------------------------------------------ *\
+     Find the first entry of the offline code database matching a
+     command, by binary search in the table sorted by command. Count
+     receives the number of consecutive entries sharing this command
+                   (0 when the command is unknown).
+\* ------------------------------------------------------------------ */
+UINT32 database_find(UINT64 Code, UINT16 *Count)
+{
+  UINT32 High;
+  UINT32 Low;
+  UINT32 Middle;
+
+
+  *Count = 0;
+  if (Code > 0xFFFFFFFFull) return 0;  // database only holds 32-bit commands.
+
+  /* Lower bound: first entry whose command is not smaller than Code. */
+  Low  = 0;
+  High = IrDatabaseTotal;
+  while (Low < High)
+  {
+    Middle = Low + ((High - Low) / 2);
+    if (IrDatabase[Middle].Code < (UINT32)Code)
+      Low = Middle + 1;
+    else
+      High = Middle;
+  }
+
+  while (((Low + *Count) < IrDatabaseTotal) && (IrDatabase[Low + *Count].Code == (UINT32)Code) && (*Count < 0xFFFF)) ++*Count;
+
+  return Low;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=decode_ir_command() */
+/* ------------------------------------------------------------------ *\
+                 Decode last infrared burst received.
+\* ------------------------------------------------------------------ */
+#include REMOTE_FILENAME
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=decode_ir_burst() */
+/* ------------------------------------------------------------------ *\
+                 Decode last infrared burst received.
+\* ------------------------------------------------------------------ */
+void decode_ir_burst(UINT8 FlagAskButton)
+{
+  UCHAR String[256];
+
+  UINT8 IrCommand;
+  UINT8 LineCount;
+
+  UINT16 Loop1UInt16;
+
+  UINT64 Code;
+
+  
+  /* Initializations. */
+  LineCount = 50;  // number of lines per page.
+
+
+  if (IrStepCount == 0)
+  {
+    printf("No infrared burst has been received yet...\r");
+    printf("You must first press a button on the remote control before selecting this menu choice.\r\r");
+    printf("Press <Enter> to return to menu: ");
+
+    input_string(String);
+
+    return;
+  }
+
+
+  if (FlagAskButton)
+  {
+    printf("Enter button name for this infrared burst: ");
+    input_string(ButtonName);
+    recent_capture_name(ButtonName);
+  }
+  
+
+  display_burst_timing(FLAG_OFF);  // first, display infrared burst timing.
+  decode_ir_command(&IrCommand);   // then, display decoded data.
+  segment_display();               // and every frame of the burst, decoded on its own.
+
+  if (segment_decode(IrResultValue, IrStepCount, &Code) == 0)
+  {
+    /* Name the probable brand, device and function from the offline code database. */
+    if (database_display(Code) == 0) printf("Command 0x%8.8llX is not in the offline code database (%lu codes).\r\r", Code, IrDatabaseTotal);
+    else printf("\r");
+  }
+  else
+  {
+    /* Rather than discarding a burst that doesn't fit the protocol, offer to learn it raw. */
+    printf("\r");
+    printf("This infrared burst doesn't fit protocol %s.\r", IrProtocol.Name);
+    printf("Press <r> to learn it raw (it can then be replayed from menu 8)...\r");
+    printf("or <Enter> to return to menu: ");
+    input_string(String);
+    if ((String[0] == 'r') || (String[0] == 'R')) raw_learn();
+  }
+
+  /*** Optionally display buttons already decoded so far. ***
+  display_header();
+
+  printf("\r");
+  printf("Number of buttons decoded: %u\r\r", RemoteDataTotal);
+  printf("        Remote control             Infrared command\r");
+  printf("           button name                      decoded\r\r");
+
+  for (Loop1UInt16 = 0; Loop1UInt16 < MAX_BUTTONS; ++Loop1UInt16)
+  {
+    printf("[%3u] %16s                   0x%8.8llX\r", Loop1UInt16, RemoteData[Loop1UInt16].ButtonName, RemoteData[Loop1UInt16].CommandId);
+    if (((Loop1UInt16 % LineCount) == 0) && (Loop1UInt16 != 0))
+    {
+      printf("\r");
+      printf("to be continued...\r");
+      printf("%s\r\r\r", Separator);
+      display_header();
+      printf("\r");
+      printf("Number of buttons decoded: %u\r\r", RemoteDataTotal);
+      printf("        Remote control             Infrared command\r");
+      printf("           button name                      decoded\r\r");
+    }
+  }
+  printf("%s\r\r\r", Separator);
+  ***/
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=decode_ir_data() */
+/* ------------------------------------------------------------------ *\
+       Decode an infrared frame silently, using the protocol descriptor
+          of the remote control file. Duration[0] is the Low level
+        of the "get-ready" bit. Returns 0 when a complete frame has
+                       been decoded, 1 otherwise.
+\* ------------------------------------------------------------------ */
+UINT8 decode_ir_data(volatile UINT32 *Duration, UINT16 StepCount, UINT64 *Code)
+{
+  UINT8 BitNumber;
+
+  UINT32 High;
+  UINT32 Low;
+
+
+  /* Initializations. */
+  *Code = 0ll;
+
+
+  if (StepCount < (2 + (IrProtocol.NumberOfBits * 2))) return 1;
+
+  /* Validate "get-ready" Low level. */
+  if ((Duration[0] < ((IrProtocol.HeaderLow * (100 - PROTOCOL_TOLERANCE)) / 100)) || (Duration[0] > ((IrProtocol.HeaderLow * (100 + PROTOCOL_TOLERANCE)) / 100))) return 1;
+
+
+  for (BitNumber = 0; BitNumber < IrProtocol.NumberOfBits; ++BitNumber)
+  {
+    Low  = Duration[2 + (BitNumber * 2)];
+    High = Duration[3 + (BitNumber * 2)];
+
+    /* Low level is the first half bit and is the same for "0" and "1". */
+    if (Low > IrProtocol.TriggerPoint01) return 1;
+
+    /* High level determines if this is a 0 or 1. */
+    if (High >= (IrProtocol.TriggerPoint01 * 4)) return 1;
+    *Code <<= 1;
+    if (High > IrProtocol.TriggerPoint01) ++*Code;
+  }
+
+  return 0;
+}
+
+
+
+
+
+#ifdef USE_FREERTOS
+/* $PAGE */
+/* $TITLE=decode_task() */
+/* ------------------------------------------------------------------ *\
+       FreeRTOS task (core 1) decoding bursts received from capture
+           task and handing the result over to console task.
+\* ------------------------------------------------------------------ */
+void decode_task(void *Param)
+{
+  static struct burst_message Burst;  // too big for task stack.
+
+  UINT64 StartTime;
+
+  struct decode_message Message;
+
+
+  while (1)
+  {
+    xQueueReceive(BurstQueue, &Burst, portMAX_DELAY);
+
+    StartTime           = time_us_64();
+    Message.FlagDecoded = (segment_decode(Burst.Duration, Burst.StepCount, &Message.Code) == 0);
+    Message.DecodeTime  = (UINT32)(time_us_64() - StartTime);
+    Message.Time        = Burst.Time;
+    Message.StepCount   = Burst.StepCount;
+
+    xQueueSend(DecodeQueue, &Message, 0);  // console is best effort.
+  }
+}
+#endif  // USE_FREERTOS
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=diff_bits() */
+/* ------------------------------------------------------------------ *\
+       Display two commands bit by bit (most significant bit first,
+           as received) and flag the bits that differ.
+\* ------------------------------------------------------------------ */
+void diff_bits(UINT64 CodeA, UINT64 CodeB)
+{
+  UINT8 BitNumber;
+
+  UINT64 Mask;
+
+
+  Mask = CodeA ^ CodeB;
+
+  printf("          A: ");
+  for (BitNumber = IrProtocol.NumberOfBits; BitNumber > 0; --BitNumber)
+    printf("%c%s", ((CodeA >> (BitNumber - 1)) & 0x01) ? '1' : '0', (((BitNumber - 1) % 8) == 0) ? " " : "");
+  printf("   0x%8.8llX\r", CodeA);
+
+  printf("          B: ");
+  for (BitNumber = IrProtocol.NumberOfBits; BitNumber > 0; --BitNumber)
+    printf("%c%s", ((CodeB >> (BitNumber - 1)) & 0x01) ? '1' : '0', (((BitNumber - 1) % 8) == 0) ? " " : "");
+  printf("   0x%8.8llX\r", CodeB);
+
+  printf("             ");
+  for (BitNumber = IrProtocol.NumberOfBits; BitNumber > 0; --BitNumber)
+    printf("%c%s", ((Mask >> (BitNumber - 1)) & 0x01) ? '^' : ' ', (((BitNumber - 1) % 8) == 0) ? " " : "");
+  printf("   %u bit(s) differ\r\r", __builtin_popcountll(Mask));
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=diff_captures() */
+/* ------------------------------------------------------------------ *\
+     Compare two recent captures, bit by bit and step by step. Both
+      bursts are aligned on their first "get-ready" Low level, so
+     that a glitch received before the frame doesn't shift every step.
+\* ------------------------------------------------------------------ */
+void diff_captures(UINT8 IndexA, UINT8 IndexB)
+{
+  UINT16 ChangeCount;
+  UINT16 Loop1UInt16;
+  UINT16 StartA;
+  UINT16 StartB;
+  UINT16 StepCount;
+
+  UINT32 DurationA;
+  UINT32 DurationB;
+  UINT32 Largest;
+
+
+  /* Bits. */
+  printf("Capture A: %s\r", RecentCapture[IndexA].ButtonName);
+  printf("Capture B: %s\r\r", RecentCapture[IndexB].ButtonName);
+  if (RecentCapture[IndexA].FlagDecoded && RecentCapture[IndexB].FlagDecoded)
+    diff_bits(RecentCapture[IndexA].Code, RecentCapture[IndexB].Code);
+  else
+    printf("At least one capture doesn't fit protocol %s, comparing timing only.\r\r", IrProtocol.Name);
+
+
+  /* Align both bursts on their "get-ready" Low level. */
+  for (StartA = 0; StartA < RecentCapture[IndexA].StepCount; StartA += 2)
+    if (RecentCapture[IndexA].Duration[StartA] > ((IrProtocol.HeaderLow * (100 - PROTOCOL_TOLERANCE)) / 100)) break;
+  for (StartB = 0; StartB < RecentCapture[IndexB].StepCount; StartB += 2)
+    if (RecentCapture[IndexB].Duration[StartB] > ((IrProtocol.HeaderLow * (100 - PROTOCOL_TOLERANCE)) / 100)) break;
+  if ((StartA >= RecentCapture[IndexA].StepCount) || (StartB >= RecentCapture[IndexB].StepCount))
+  {
+    StartA = 0;
+    StartB = 0;
+  }
+
+  StepCount = RecentCapture[IndexA].StepCount - StartA;
+  if ((RecentCapture[IndexB].StepCount - StartB) < StepCount) StepCount = RecentCapture[IndexB].StepCount - StartB;
+
+
+  /* Steps whose duration changed by more than DIFF_TOLERANCE percent. */
+  printf(" Step   Logic   Duration A   Duration B\r");
+  printf("number  level\r\r");
+  ChangeCount = 0;
+  for (Loop1UInt16 = 0; Loop1UInt16 < StepCount; ++Loop1UInt16)
+  {
+    DurationA = RecentCapture[IndexA].Duration[StartA + Loop1UInt16];
+    DurationB = RecentCapture[IndexB].Duration[StartB + Loop1UInt16];
+    Largest   = (DurationA > DurationB) ? DurationA : DurationB;
+
+    if (((DurationA > DurationB) ? (DurationA - DurationB) : (DurationB - DurationA)) * 100 > (Largest * DIFF_TOLERANCE))
+    {
+      printf("  %3u   %4s       %5lu        %5lu\r", Loop1UInt16 + 1, LevelString[Loop1UInt16 % 2], DurationA, DurationB);
+      ++ChangeCount;
+    }
+  }
+  printf("\r");
+  printf("%u step(s) changed out of %u compared (A has %u steps, B has %u steps).\r", ChangeCount, StepCount, RecentCapture[IndexA].StepCount, RecentCapture[IndexB].StepCount);
+  printf("%s\r\r", Separator);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=diff_fields() */
+/* ------------------------------------------------------------------ *\
+       Find constant and variable bit fields across the whole button
+     list. Constant bits are the same for every button (address),
+     variable bits are not (command). An 8-bit field that is always
+        the complement of the previous one is reported as a check.
+\* ------------------------------------------------------------------ */
+void diff_fields(void)
+{
+  UINT8 BitNumber;
+  UINT8 FieldFirst;
+  UINT8 FlagConstant;
+  UINT8 FlagInverted;
+  UINT8 Shift;
+
+  UINT16 Loop1UInt16;
+
+  UINT64 AndMask;
+  UINT64 ConstantMask;
+  UINT64 OrMask;
+
+
+  if (RemoteDataTotal < 2)
+  {
+    printf("At least two buttons must be recorded in the button list.\r\r");
+    return;
+  }
+
+
+  /* Bits that are always 0 or always 1. */
+  AndMask = ~0ll;
+  OrMask  = 0ll;
+  for (Loop1UInt16 = 0; Loop1UInt16 < RemoteDataTotal; ++Loop1UInt16)
+  {
+    AndMask &= RemoteData[Loop1UInt16].CommandId;
+    OrMask  |= RemoteData[Loop1UInt16].CommandId;
+  }
+  ConstantMask = ~(AndMask ^ OrMask);
+
+
+  printf("Bit fields across %u buttons (bit %u is received first):\r\r", RemoteDataTotal, IrProtocol.NumberOfBits - 1);
+
+  BitNumber = IrProtocol.NumberOfBits;
+  while (BitNumber > 0)
+  {
+    /* Find the run of bits having the same nature. */
+    FieldFirst   = BitNumber - 1;
+    FlagConstant = (ConstantMask >> FieldFirst) & 0x01;
+    while ((BitNumber > 0) && (((ConstantMask >> (BitNumber - 1)) & 0x01) == FlagConstant)) --BitNumber;
+
+    if (FlagConstant)
+      printf("    bits %2u to %2u: constant 0x%llX -> address\r", FieldFirst, BitNumber, (AndMask >> BitNumber) & ((1ll << (FieldFirst - BitNumber + 1)) - 1));
+    else
+      printf("    bits %2u to %2u: variable -> command\r", FieldFirst, BitNumber);
+  }
+
+
+  /* Look for 8-bit fields that are always the complement of the previous 8 bits. */
+  printf("\r");
+  for (Shift = 0; (Shift + 16) <= IrProtocol.NumberOfBits; Shift += 8)
+  {
+    FlagInverted = FLAG_ON;
+    for (Loop1UInt16 = 0; Loop1UInt16 < RemoteDataTotal; ++Loop1UInt16)
+    {
+      if ((((RemoteData[Loop1UInt16].CommandId >> Shift) ^ (RemoteData[Loop1UInt16].CommandId >> (Shift + 8))) & 0xFF) != 0xFF)
+      {
+        FlagInverted = FLAG_OFF;
+        break;
+      }
+    }
+    if (FlagInverted)
+      printf("    bits %2u to %2u: always the complement of bits %2u to %2u -> check\r", Shift + 7, Shift, Shift + 15, Shift + 8);
+  }
+  printf("%s\r\r", Separator);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=diff_menu() */
+/* ------------------------------------------------------------------ *\
+                        Bit-level diff sub-menu.
+\* ------------------------------------------------------------------ */
+void diff_menu(void)
+{
+  UCHAR String[128];
+
+  UINT8 IndexA;
+  UINT8 IndexB;
+  UINT8 Loop1UInt8;
+
+  UINT32 Oldest;
+
+
+  while (1)
+  {
+    printf("\r\r");
+    display_header();
+    printf("\r");
+    printf("     1) Compare two recent captures (bits and timing).\r");
+    printf("     2) Compare two buttons from the button list (bits).\r");
+    printf("     3) Find address / command bit fields across the whole button list.\r");
+    printf("\r");
+    printf("        Enter an option (or <Enter> to return to main menu): ");
+    input_string(String);
+    if (String[0] == 0x0D) return;
+    printf("\r\r");
+
+
+    switch (atoi(String))
+    {
+      case (1):
+        Oldest = (RecentTotal > RECENT_CAPTURES) ? (RecentTotal - RECENT_CAPTURES) : 0;
+        printf("Recent captures (most recent last):\r\r");
+        for (Loop1UInt8 = 0; Loop1UInt8 < (RecentTotal - Oldest); ++Loop1UInt8)
+        {
+          IndexA = (Oldest + Loop1UInt8) % RECENT_CAPTURES;
+          printf("[%u] %16s   %3u steps   ", Loop1UInt8, RecentCapture[IndexA].ButtonName, RecentCapture[IndexA].StepCount);
+          if (RecentCapture[IndexA].FlagDecoded)
+            printf("0x%8.8llX\r", RecentCapture[IndexA].Code);
+          else
+            printf("undecoded\r");
+        }
+        printf("\r");
+        if ((RecentTotal - Oldest) < 2)
+        {
+          printf("At least two captures are needed.\r\r");
+          break;
+        }
+
+        printf("Enter first capture number: ");
+        input_string(String);
+        IndexA = atoi(String);
+        printf("Enter second capture number: ");
+        input_string(String);
+        IndexB = atoi(String);
+        if ((IndexA >= (RecentTotal - Oldest)) || (IndexB >= (RecentTotal - Oldest)))
+        {
+          printf("\rInvalid capture number...\r\r");
+          break;
+        }
+        printf("\r");
+        diff_captures((Oldest + IndexA) % RECENT_CAPTURES, (Oldest + IndexB) % RECENT_CAPTURES);
+      break;
+
+      case (2):
+        display_button_list();
+        printf("Enter first button number: ");
+        input_string(String);
+        IndexA = atoi(String);
+        printf("Enter second button number: ");
+        input_string(String);
+        IndexB = atoi(String);
+        if ((IndexA >= RemoteDataTotal) || (IndexB >= RemoteDataTotal))
+        {
+          printf("\rInvalid button number...\r\r");
+          break;
+        }
+        printf("\r%s / %s\r", RemoteData[IndexA].ButtonName, RemoteData[IndexB].ButtonName);
+        diff_bits(RemoteData[IndexA].CommandId, RemoteData[IndexB].CommandId);
+      break;
+
+      case (3):
+        diff_fields();
+      break;
+
+      default:
+        printf("           Invalid choice... please re-enter [%s]\r\r", String);
+      break;
+    }
+  }
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=display_burst_timing() */
+/* ------------------------------------------------------------------ *\
+            Display the infrared burst timing information.
+\* ------------------------------------------------------------------ */
+void display_burst_timing(UINT8 FlagAskButton)
+{
+  UCHAR Dum1UChar[128];
+  UCHAR String[128];
+
+  UINT16 CurrentHiCount;
+  UINT16 Loop1UInt16;
+  UINT16 Loop2UInt16;
+  UINT16 LineCount;
+
+
+  /* Initializations. */
+  LineCount = 50;  // number of lines per page.
+
+
+  if (IrStepCount == 0)
+  {
+    printf("No infrared burst has been received yet...\r");
+    printf("You must first press a button on the remote control before selecting this menu choice.\r\r");
+    printf("Press <Enter> to return to menu: ");
+
+    input_string(String);
+
+    return;
+  }
+
+
+  if (FlagAskButton)
+  {
+    printf("Enter button name for this infrared burst: ");
+    input_string(ButtonName);
+    recent_capture_name(ButtonName);
+  }
+  
+
+  for (Loop1UInt16 = 0; Loop1UInt16 < IrStepCount; Loop1UInt16 += (LineCount * 2))
+  {
+    printf("\r\r\r\r\r");
+    display_header();
+
+    /* Display Button name. */
+    printf("Button: %s\r\r", ButtonName);
+
+    /* Display timing for every logic level change of last received infrared burst. */
+    printf(" Step      Logic    Duration                     Step      Logic    Duration\r");
+    printf("number     level                                number     level\r\r");
+
+    for (Loop2UInt16 = Loop1UInt16; Loop2UInt16 < (Loop1UInt16 + LineCount); ++Loop2UInt16)
+    {
+      printf("  %3u       %4s      %5lu", Loop2UInt16 + 1, LevelString[IrLevel[Loop2UInt16]], IrResultValue[Loop2UInt16]);
+
+      if (IrStepCount > (Loop2UInt16 + LineCount))
+      {
+        printf("                       %3u       %4s      %5lu", Loop2UInt16 + LineCount + 1, LevelString[IrLevel[Loop2UInt16 + LineCount]], IrResultValue[Loop2UInt16 + LineCount]);
+      }
+      printf("\r");
+
+      if (Loop2UInt16 == IrStepCount)
+      {
+        printf("\r");
+        printf("%s", Separator);
+        break;  // get out of "for" loop when all steps have been displayed.
+      }
+    }
+
+    if (IrStepCount > (Loop1UInt16 + (LineCount * 2)))
+    {
+      printf("\r");
+      printf("to be continued\r");
+    }
+    printf("%s", Separator);
+  }
+
+  return;
+}
+ 
+
+
+
+
+/* $PAGE */
+/* $TITLE=display_button_list() */
+/* ------------------------------------------------------------------ *\
+               Display complete list of buttons decoded.
+\* ------------------------------------------------------------------ */
+void display_button_list(void)
+{
+  UINT8  LineCount;
+
+  UINT16 Loop1UInt16;
+
+
+  /* Initializations. */
+  LineCount = 50;
+
+
+  display_header();
+  printf("\r");
+  printf("Number of buttons decoded: %u\r\r", RemoteDataTotal);
+  printf("        Remote control             Infrared command\r");
+  printf("           button name                      decoded\r\r");
+
+  for (Loop1UInt16 = 0; Loop1UInt16 < RemoteDataTotal; ++Loop1UInt16)
+  {
+    printf("[%3u] %16s                   0x%8.8llX\r", Loop1UInt16, RemoteData[Loop1UInt16].ButtonName, RemoteData[Loop1UInt16].CommandId);
+    
+    if (((Loop1UInt16 % LineCount) == 0) && (Loop1UInt16 != 0))
+    {
+      printf("\r");
+      printf("to be continued...\r");
+      printf("%s\r\r\r", Separator);
+      display_header();
+      printf("\r");
+      printf("Number of buttons decoded: %u\r\r", RemoteDataTotal);
+      printf("        Remote control             Infrared command\r");
+      printf("           button name                      decoded\r\r");
+    }
+  }
+  printf("%s\r\r\r", Separator);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=display_events() */
+/* ------------------------------------------------------------------ *\
+      Display frames decoded by the capture pipeline, polling the
+      application queue exactly as an application would (see IrEvent.h),
+                     until a key is pressed.
+\* ------------------------------------------------------------------ */
+void display_events(void)
+{
+  struct ir_event Event;
+
+
+  printf("Displaying frames decoded with protocol %s... press any key to stop.\r\r", IrProtocol.Name);
+  printf("     Time (usec)   Protocol     Address    Command    Repeat\r\r");
+
+  while (getchar_timeout_us(0) == PICO_ERROR_TIMEOUT)
+  {
+    if (ir_event_poll(&Event) == 0)
+    {
+      /* Queue is empty, sleep until next event (or timer tick). */
+      event_wait();
+      continue;
+    }
+
+    printf("%16llu   %8s      0x%4.4lX       0x%2.2lX       %s\r", Event.Time, Event.Protocol, Event.Address, Event.Command, Event.FlagRepeat ? "yes" : "no");
+  }
+
+  printf("\r");
+  printf("Events dropped (queue full): %lu\r", ir_event_dropped());
+  printf("%s\r\r", Separator);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=display_header() */
+/* ------------------------------------------------------------------ *\
+              Display header for burst timing information.
+\* ------------------------------------------------------------------ */
+void display_header(void)
+{
+  UCHAR String[128];
+
+  UINT16 Loop1UInt16;
+
+
+  printf("%s", Separator);
+  
+
+  sprintf(String, "Flash-Remote-Analyzer\r");
+  for (Loop1UInt16 = 0; Loop1UInt16 < ((strlen(Separator) - strlen(String)) / 2); ++Loop1UInt16)
+    printf(" ");
+  printf("%s", String);
+  
+
+  sprintf(String, "Microcontroller is a ");
+  if (PicoType == TYPE_PICO)
+    sprintf(&String[strlen(String)], "Pico\r");
+  else
+    sprintf(&String[strlen(String)], "Pico W\r");
+  for (Loop1UInt16 = 0; Loop1UInt16 < ((strlen(Separator) - strlen(String)) / 2); ++Loop1UInt16)
+    printf(" ");
+  printf("%s", String);
+  
+
+  sprintf(String, "Pico's Unique ID: %s\r", PicoUniqueId);
+  for (Loop1UInt16 = 0; Loop1UInt16 < ((strlen(Separator) - strlen(String)) / 2); ++Loop1UInt16)
+    printf(" ");
+  printf("%s", String);
+  
+
+  sprintf(String, "Brand under analysis: %s\r", BrandName);
+  for (Loop1UInt16 = 0; Loop1UInt16 < ((strlen(Separator) - strlen(String)) / 2); ++Loop1UInt16)
+    printf(" ");
+  printf("%s", String);
+
+
+  sprintf(String, "Remote control model number: %s\r", RemoteModel);
+  for (Loop1UInt16 = 0; Loop1UInt16 < ((strlen(Separator) - strlen(String)) / 2); ++Loop1UInt16)
+    printf(" ");
+  printf("%s", String);
+
+
+  sprintf(String, "Step count: %u\r", IrStepCount);
+  for (Loop1UInt16 = 0; Loop1UInt16 < ((strlen(Separator) - strlen(String)) / 2); ++Loop1UInt16)
+    printf(" ");
+  printf("%s", String);
+
+
+  printf("%s", Separator);
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=dormant_mode() */
+/* ------------------------------------------------------------------ *\
+      Low-power receiver mode. The Pico sleeps dormant (all clocks
+      stopped) until the first edge of an infrared burst wakes it up.
+      The timer is stopped while dormant and restarts only once the
+      crystal oscillator is back, so the beginning of the "get-ready"
+     Low level is lost: only the part timed after wake-up is recorded
+     and reported. For decoding, this truncated Low level is replaced
+       by the nominal one of the protocol descriptor (on a copy, the
+                     captured durations are left as is).
+     The clock restart time (from the timer restart to the end of
+     clocks_init()) is measured on every wake-up. The time needed by
+     the crystal oscillator to start, before the timer runs again, and
+      the current draw can't be measured by the Pico itself (use an
+                    oscilloscope and an ammeter).
+      USB is disconnected for as long as dormant mode lasts; use the
+      UART console to return to menu (press a key after a burst).
+\* ------------------------------------------------------------------ */
+void dormant_mode(void)
+{
+  UINT8 FlagTruncated;
+
+  UINT16 Loop1UInt16;
+
+  UINT32 DormantWakeCount;
+  UINT32 RestartMax;
+  UINT32 RestartMin;
+  UINT32 RestartTime;
+
+  UINT64 Code;
+  UINT64 WakeTime;
+
+  static UINT32 Duration[MAX_IR_READINGS];  // too big for stack.
+
+
+  /* Initializations. */
+  DormantWakeCount = 0;
+  RestartMax       = 0;
+  RestartMin       = 0xFFFFFFFF;
+
+
+  printf("Entering dormant mode... USB console is disconnected until the end of dormant mode.\r");
+  printf("Press a key on the UART console after an infrared burst to return to menu.\r\r");
+  sleep_ms(10);  // let USB send what has been printed.
+
+  /* Detach from USB host once for all: its clock stops on every sleep and each wake-up is too short for enumeration. */
+  tud_disconnect();
+
+  while (1)
+  {
+    /* Keep the infrared ISR out of the way while clocks are being stopped / restarted. */
+    gpio_set_irq_enabled(IR_RX, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, false);
+    init_burst_variables();
+    uart_tx_wait_blocking(uart0);
+
+    RestartTime = dormant_sleep();
+    WakeTime = time_us_64();
+    ++DormantWakeCount;
+    if (RestartTime < RestartMin) RestartMin = RestartTime;
+    if (RestartTime > RestartMax) RestartMax = RestartTime;
+
+
+    /* If the "get-ready" Low level is still in progress, time what is left of it from wake-up. */
+    FlagTruncated = FLAG_OFF;
+    if (gpio_get(IR_RX) == 0)
+    {
+      IrInitialValue[0] = WakeTime;
+      FlagTruncated = FLAG_ON;
+    }
+    gpio_acknowledge_irq(IR_RX, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE);
+    gpio_set_irq_enabled(IR_RX, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true);
+
+
+    /* Wait for the end of the burst (or give up and go back to sleep). */
+    while ((IrStepCount == 0) || ((time_us_64() - IrInitialValue[IrStepCount]) < IrProtocol.Separator))
+    {
+      if ((time_us_64() - WakeTime) > DORMANT_AWAKE_TIMEOUT) break;
+    }
+    if (IrStepCount == 0) continue;
+
+
+    for (Loop1UInt16 = 0; Loop1UInt16 < IrStepCount; ++Loop1UInt16)
+      Duration[Loop1UInt16] = IrResultValue[Loop1UInt16];
+    if (FlagTruncated && (Duration[0] < IrProtocol.HeaderLow)) Duration[0] = IrProtocol.HeaderLow;
+
+    if (segment_decode(Duration, IrStepCount, &Code) == 0)
+      printf("[%6lu] 0x%8.8llX   %3u steps   clock restart: %4lu usec", DormantWakeCount, Code, IrStepCount, RestartTime);
+    else
+      printf("[%6lu] undecoded burst   %3u steps   clock restart: %4lu usec", DormantWakeCount, IrStepCount, RestartTime);
+    if (FlagTruncated)
+      printf("   \"get-ready\" Low level truncated by wake-up (%lu usec timed)", IrResultValue[0]);
+    printf("\r");
+
+
+    if (getchar_timeout_us(0) != PICO_ERROR_TIMEOUT) break;
+  }
+
+
+  /* Back to the USB console. */
+  tud_connect();
+
+  printf("\r");
+  printf("Number of wake-ups: %lu\r", DormantWakeCount);
+  if (DormantWakeCount)
+    printf("Clock restart time: min %lu usec   max %lu usec (crystal oscillator start-up not included)\r", RestartMin, RestartMax);
+  printf("%s\r\r", Separator);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=dormant_sleep() */
+/* ------------------------------------------------------------------ *\
+       Stop all clocks until the infrared sensor line goes Low, then
+      restart them. Before going dormant, everything is moved to the
+      crystal oscillator so that it is the only clock to stop; PLLs
+     are restarted by clocks_init() on wake-up and UART is re-initialized
+      for its restored clock frequency. The timer, clocked from the
+      crystal oscillator, runs again as soon as xosc_dormant() returns:
+        returns the time (in usec) taken by the clock restart.
+\* ------------------------------------------------------------------ */
+UINT32 dormant_sleep(void)
+{
+  UINT64 RestartTime;
+
+
+  /* Run everything from the crystal oscillator. */
+  clock_configure(clk_ref,  CLOCKS_CLK_REF_CTRL_SRC_VALUE_XOSC_CLKSRC, 0, XOSC_MHZ * MHZ, XOSC_MHZ * MHZ);
+  clock_configure(clk_sys,  CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLK_REF,     0, XOSC_MHZ * MHZ, XOSC_MHZ * MHZ);
+  clock_stop(clk_usb);
+  clock_stop(clk_adc);
+  clock_configure(clk_peri, 0, CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_XOSC_CLKSRC, XOSC_MHZ * MHZ, XOSC_MHZ * MHZ);
+  pll_deinit(pll_sys);
+  pll_deinit(pll_usb);
+
+
+  /* Go dormant. Execution stops on xosc_dormant() until the infrared sensor line goes Low. */
+  gpio_set_dormant_irq_enabled(IR_RX, GPIO_IRQ_EDGE_FALL, true);
+  xosc_dormant();
+  RestartTime = time_us_64();
+  gpio_acknowledge_irq(IR_RX, GPIO_IRQ_EDGE_FALL);
+  gpio_set_dormant_irq_enabled(IR_RX, GPIO_IRQ_EDGE_FALL, false);
+
+
+  /* Fast clock restart, then UART for its restored clock frequency. */
+  clocks_init();
+  uart_init(uart0, 921600);
+
+  return (UINT32)(time_us_64() - RestartTime);
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=event_post() */
+/* ------------------------------------------------------------------ *\
+      Post an event to the central event queue and wake up the core
+     sleeping in event_wait(). May be called from interrupt context.
+        When the queue is full, the new event is dropped (the main
+           loop always re-checks the state it is waiting for).
+\* ------------------------------------------------------------------ */
+void event_post(UINT8 Event)
+{
+  UINT8 NextHead;
+
+  UINT32 InterruptState;
+
+
+  /* Several interrupt handlers may post events: keep them from interleaving. */
+  InterruptState = save_and_disable_interrupts();
+  NextHead = (EventHead + 1) % EVENT_QUEUE_SIZE;
+  if (NextHead != EventTail)
+  {
+    EventQueue[EventHead] = Event;
+    EventHead = NextHead;
+  }
+  restore_interrupts(InterruptState);
+
+  __sev();  // wake up core sleeping in __wfe().
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=event_timer_callback() */
+/* ------------------------------------------------------------------ *\
+        Periodic timer callback posting EVENT_TIMER, and also
+       EVENT_USB_ATTACH when USB CDC connection gets established.
+\* ------------------------------------------------------------------ */
+bool event_timer_callback(repeating_timer_t *Timer)
+{
+  static UINT8 FlagUsbConnected = FLAG_OFF;
+
+
+  if (stdio_usb_connected())
+  {
+    if (FlagUsbConnected == FLAG_OFF) event_post(EVENT_USB_ATTACH);
+    FlagUsbConnected = FLAG_ON;
+  }
+  else
+  {
+    FlagUsbConnected = FLAG_OFF;
+  }
+
+  event_post(EVENT_TIMER);
+
+  return true;  // keep repeating.
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=event_wait() */
+/* ------------------------------------------------------------------ *\
+      Sleep (__wfe) until an event is available in the central event
+      queue and return it. Only the main loop consumes events, so the
+                  tail index needs no protection.
+\* ------------------------------------------------------------------ */
+UINT8 event_wait(void)
+{
+  UINT8 Event;
+
+
+  while (EventHead == EventTail) __wfe();
+
+  Event = EventQueue[EventTail];
+  EventTail = (EventTail + 1) % EVENT_QUEUE_SIZE;
+
+  return Event;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=encode_ir_frame() */
+/* ------------------------------------------------------------------ *\
+       Build the Mark / Space durations (in micro-seconds) of an
+       infrared frame from a command, using the protocol descriptor
+       of the remote control file (see IrEncode.c). Duration must hold
+        at least (NumberOfBits * 2) + 3 entries. Returns the number
+                               of steps.
+\* ------------------------------------------------------------------ */
+UINT16 encode_ir_frame(UINT64 Code, UINT32 *Duration)
+{
+  return ir_encode_frame(&IrProtocol, Code, Duration, ir_encode_length(&IrProtocol));
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=enter_remote_id() */
+/* ------------------------------------------------------------------ *\
+        Assign brand name and serial number to the remote control.
+\* ------------------------------------------------------------------ */
+void enter_remote_id(void)
+{
+  UCHAR Dum1UChar[64];
+
+
+  printf("Current remote control brand is %s\r", BrandName);
+  printf("Enter the brand if it must be different: ");
+  input_string(Dum1UChar);
+  if ((Dum1UChar[0] != 0x00) && (Dum1UChar[0] != 0x0D))
+    strcpy(BrandName, Dum1UChar);
+  printf("\r\r");
+
+
+  printf("Current remote control model number is %s\r", RemoteModel);
+  printf("Enter the remote model number if it must be different: ");
+  input_string(Dum1UChar);
+  if ((Dum1UChar[0] != 0x00) && (Dum1UChar[0] != 0x0D))
+    strcpy(RemoteModel, Dum1UChar);
+  printf("\r\r");
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=get_pico_id() */
+/* ------------------------------------------------------------------ *\
+         Determine if the microcontroller is a Pico or a Pico W
+                    and retrieve its Unique Number.
+\* ------------------------------------------------------------------ */
+UINT8 get_pico_id(void)
+{
+  UINT8 Loop1UInt8;
+  
+  UINT16 AdcValue1;
+  UINT16 AdcValue2;
+
+  float Volts1;
+  float Volts2;
+
+  pico_unique_board_id_t board_id;  // Pico's Unique ID.
+
+
+  /* Select power supply input. */
+  adc_select_input(3);
+  gpio_put(PICO_LED, true);
+
+  /* Read ADC converter raw value. */
+  AdcValue1 = adc_read();
+
+  /* Convert raw value to voltage value. */
+  Volts1 = (3 * (AdcValue1 * 3.3f / 4096));
+
+
+
+  /* The important power supply value to consider is when GPIO25 is Low. */
+  gpio_put(PICO_LED, false);
+    
+  /* Read ADC converter raw value. */
+  AdcValue2 = adc_read();
+
+  /* Convert raw value to voltage value. */
+  Volts2 = (3 * (AdcValue2 * 3.3f / 4096));
+  if (Volts2 > 3)
+    PicoType = TYPE_PICO;
+  else
+    PicoType = TYPE_PICO_W;
+
+
+  /* Retrieve Pico Unique Number from flash memory IC. */
+  pico_get_unique_board_id(&board_id);
+
+
+  /* Build-up the Unique ID string in hex. */
+  PicoUniqueId[0] = 0x00;  // initialize as null string.
+  for (Loop1UInt8 = 0; Loop1UInt8 < PICO_UNIQUE_BOARD_ID_SIZE_BYTES; ++Loop1UInt8)
+  {
+    sprintf(&PicoUniqueId[strlen(PicoUniqueId)], "%2.2X", board_id.id[Loop1UInt8]);
+    if ((Loop1UInt8 % 2) && (Loop1UInt8 != 7))
+      sprintf(&PicoUniqueId[strlen(PicoUniqueId)], "-");
+  }
+  
+  return PicoType;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=headless_capture() */
+/* ------------------------------------------------------------------ *\
+      Capture and log infrared bursts until a console is attached
+      (USB CDC enumerated by the PC, or any key received on UART).
+      The Pico sleeps in event_wait() between infrared bursts.
+      Bursts are decoded silently with the protocol descriptor and
+     kept in HeadlessLog, which is displayed once the console shows up.
+\* ------------------------------------------------------------------ */
+void headless_capture(void)
+{
+  UINT8 Event;
+  UINT8 LogIndex;
+
+  UINT16 StepCount;
+
+  UINT32 Loop1UInt32;
+
+  UINT64 ToneTime;
+
+
+  /* Initializations. */
+  HeadlessLogTotal = 0;
+  ToneTime         = 0ll;
+
+
+  while (!stdio_usb_connected())
+  {
+    Event = event_wait();
+
+    /* Any key received on UART also attaches the console. */
+    if ((Event == EVENT_USB_ATTACH) || (Event == EVENT_KEY_INPUT)) break;
+
+    /* Short tone now and then to tell that no console is attached. */
+    if ((Event == EVENT_TIMER) && (time_us_64() > ToneTime))
+    {
+      tone(25);
+      ToneTime = time_us_64() + HEADLESS_TONE_PERIOD;
+    }
+
+    if (burst_complete() == 0) continue;
+    StepCount = IrStepCount;
+
+    LogIndex = HeadlessLogTotal % HEADLESS_LOG_SIZE;
+    HeadlessLog[LogIndex].Time        = IrInitialValue[0];
+    HeadlessLog[LogIndex].StepCount   = StepCount;
+    HeadlessLog[LogIndex].FlagDecoded = (segment_decode(IrResultValue, StepCount, &HeadlessLog[LogIndex].Code) == 0);
+    ++HeadlessLogTotal;
+
+    init_burst_variables();
+  }
+
+
+  /* Console is now attached, show what has been received so far. */
+  printf("\r\r");
+  printf("Infrared capture armed %llu usec after boot.\r", CaptureArmedTime);
+  printf("Number of infrared bursts received before console was attached: %lu\r", HeadlessLogTotal);
+  if (HeadlessLogTotal)
+  {
+    printf("\r");
+    printf("   Time (usec)     Steps     Command\r\r");
+    Loop1UInt32 = (HeadlessLogTotal > HEADLESS_LOG_SIZE) ? (HeadlessLogTotal - HEADLESS_LOG_SIZE) : 0;  // oldest entry still in log.
+    for (; Loop1UInt32 < HeadlessLogTotal; ++Loop1UInt32)
+    {
+      LogIndex = Loop1UInt32 % HEADLESS_LOG_SIZE;
+      if (HeadlessLog[LogIndex].FlagDecoded)
+        printf("[%3lu] %12llu     %3u       0x%8.8llX\r", Loop1UInt32, HeadlessLog[LogIndex].Time, HeadlessLog[LogIndex].StepCount, HeadlessLog[LogIndex].Code);
+      else
+        printf("[%3lu] %12llu     %3u       undecoded\r", Loop1UInt32, HeadlessLog[LogIndex].Time, HeadlessLog[LogIndex].StepCount);
+    }
+  }
+  printf("%s\r\r", Separator);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=histogram_add() */
+/* ------------------------------------------------------------------ *\
+     Add the durations of last infrared burst to the duration histograms,
+     in a single pass. Bins are on a log scale (4 bins per octave): the
+     bin number comes from the position of the most significant bit of
+      the duration and from the two bits following it, so no sorting
+                   and no floating point is needed.
+\* ------------------------------------------------------------------ */
+void histogram_add(void)
+{
+  UINT8 Bin;
+  UINT8 Level;
+  UINT8 MsBit;
+
+  UINT16 Loop1UInt16;
+
+  UINT32 Duration;
+
+
+  for (Loop1UInt16 = 0; Loop1UInt16 < IrStepCount; ++Loop1UInt16)
+  {
+    Duration = IrResultValue[Loop1UInt16];
+    Level    = IrLevel[Loop1UInt16];
+    if ((Duration == 0) || (Level > 1)) continue;
+
+    MsBit = 31 - __builtin_clz(Duration);
+    if (MsBit < HISTOGRAM_FIRST_OCTAVE)
+      Bin = 0;
+    else
+      Bin = ((MsBit - HISTOGRAM_FIRST_OCTAVE) * 4) + ((Duration >> (MsBit - 2)) & 0x03);
+    if (Bin >= HISTOGRAM_BINS) Bin = HISTOGRAM_BINS - 1;
+
+    ++Histogram[Level][Bin];
+    HistogramSum[Level][Bin] += Duration;
+    ++HistogramTotal[Level];
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=histogram_bin_floor() */
+/* ------------------------------------------------------------------ *\
+            Return the lower bound (in usec) of a histogram bin.
+\* ------------------------------------------------------------------ */
+UINT32 histogram_bin_floor(UINT8 Bin)
+{
+  UINT8 MsBit;
+
+
+  MsBit = (Bin / 4) + HISTOGRAM_FIRST_OCTAVE;
+
+  return (1ul << MsBit) + ((Bin % 4) * (1ul << (MsBit - 2)));
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=histogram_display() */
+/* ------------------------------------------------------------------ *\
+      Display duration histograms (Low levels and High levels) and
+     their clusters. A cluster is a run of adjacent non-empty bins;
+      clusters holding less than HISTOGRAM_RARE_PERCENT of durations
+     are flagged as rare (outliers, or separators between frames).
+\* ------------------------------------------------------------------ */
+void histogram_display(void)
+{
+  UCHAR Bar[HISTOGRAM_BAR_WIDTH + 1];
+
+  UINT8 ClusterFirst;
+  UINT8 Level;
+  UINT8 Loop1UInt8;
+  UINT8 Loop2UInt8;
+
+  UINT16 MaxCount;
+
+  UINT32 ClusterCount;
+  UINT32 ClusterSum;
+
+
+  for (Level = 0; Level < 2; ++Level)
+  {
+    printf("\r");
+    printf("Histogram of %s levels (%lu durations)\r\r", LevelString[Level], HistogramTotal[Level]);
+    printf("    From (usec)      Count\r\r");
+
+    MaxCount = 1;
+    for (Loop1UInt8 = 0; Loop1UInt8 < HISTOGRAM_BINS; ++Loop1UInt8)
+      if (Histogram[Level][Loop1UInt8] > MaxCount) MaxCount = Histogram[Level][Loop1UInt8];
+
+    for (Loop1UInt8 = 0; Loop1UInt8 < HISTOGRAM_BINS; ++Loop1UInt8)
+    {
+      if (Histogram[Level][Loop1UInt8] == 0) continue;
+
+      memset(Bar, '*', HISTOGRAM_BAR_WIDTH);
+      Bar[((Histogram[Level][Loop1UInt8] * HISTOGRAM_BAR_WIDTH) + MaxCount - 1) / MaxCount] = 0x00;
+      printf("    %6lu          %5u   %s\r", histogram_bin_floor(Loop1UInt8), Histogram[Level][Loop1UInt8], Bar);
+    }
+
+
+    /* Clusters. */
+    printf("\r");
+    printf("Clusters of %s levels:\r", LevelString[Level]);
+    Loop1UInt8 = 0;
+    while (Loop1UInt8 < HISTOGRAM_BINS)
+    {
+      if (Histogram[Level][Loop1UInt8] == 0)
+      {
+        ++Loop1UInt8;
+        continue;
+      }
+
+      ClusterFirst = Loop1UInt8;
+      ClusterCount = 0;
+      ClusterSum   = 0;
+      for (Loop2UInt8 = Loop1UInt8; (Loop2UInt8 < HISTOGRAM_BINS) && (Histogram[Level][Loop2UInt8] != 0); ++Loop2UInt8)
+      {
+        ClusterCount += Histogram[Level][Loop2UInt8];
+        ClusterSum   += HistogramSum[Level][Loop2UInt8];
+      }
+      Loop1UInt8 = Loop2UInt8;
+
+      printf("    %6lu to %6lu usec   count %5lu   mean %6lu usec", histogram_bin_floor(ClusterFirst), (Loop2UInt8 < HISTOGRAM_BINS) ? histogram_bin_floor(Loop2UInt8) : 0xFFFFFFFF, ClusterCount, ClusterSum / ClusterCount);
+      if ((ClusterCount * 100) < (HistogramTotal[Level] * HISTOGRAM_RARE_PERCENT))
+        printf("   <-- rare (outlier or separator)");
+      printf("\r");
+    }
+  }
+  printf("%s\r\r", Separator);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=histogram_menu() */
+/* ------------------------------------------------------------------ *\
+      Build duration histograms from last infrared burst, or from
+             a set of bursts received from the remote control.
+\* ------------------------------------------------------------------ */
+void histogram_menu(void)
+{
+  UCHAR String[128];
+
+  UINT8 FlagStop;
+  UINT8 Level;
+  UINT8 Loop1UInt8;
+
+  UINT16 BurstCount;
+  UINT16 BurstTotal;
+
+
+  for (Level = 0; Level < 2; ++Level)
+  {
+    HistogramTotal[Level] = 0;
+    for (Loop1UInt8 = 0; Loop1UInt8 < HISTOGRAM_BINS; ++Loop1UInt8)
+    {
+      Histogram[Level][Loop1UInt8]    = 0;
+      HistogramSum[Level][Loop1UInt8] = 0;
+    }
+  }
+
+
+  printf("Enter number of bursts to accumulate (1 to %u, <Enter> for last burst only): ", HISTOGRAM_MAX_BURSTS);
+  input_string(String);
+  BurstTotal = (String[0] == 0x0D) ? 0 : atoi(String);
+  if (BurstTotal > HISTOGRAM_MAX_BURSTS)
+  {
+    printf("\rInvalid number of bursts...\r\r");
+    return;
+  }
+
+  if (BurstTotal == 0)
+  {
+    histogram_add();
+  }
+  else
+  {
+    printf("\r");
+    for (BurstCount = 0; BurstCount < BurstTotal; ++BurstCount)
+    {
+      init_burst_variables();
+      printf("Press a button on remote control (%u / %u), or any key to stop: ", BurstCount + 1, BurstTotal);
+      FlagStop = FLAG_OFF;
+      while (burst_complete() == 0)
+      {
+        event_wait();
+        if (getchar_timeout_us(0) != PICO_ERROR_TIMEOUT)
+        {
+          FlagStop = FLAG_ON;
+          break;
+        }
+      }
+      if (FlagStop)
+      {
+        printf("\r");
+        break;
+      }
+      printf("%u steps\r", IrStepCount);
+      histogram_add();
+    }
+  }
+
+  display_header();
+  histogram_display();
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=init_burst_variables() */
+/* ------------------------------------------------------------------ *\
+    Initialize variables that will receive next infrared data burst.
+\* ------------------------------------------------------------------ */
+void init_burst_variables(void)
+{
+  UINT Loop1UInt;
+
+
+  IrStepCount  = 0;
+  IrFrameStart = 0;
+
+  for (Loop1UInt = 0; Loop1UInt < MAX_IR_READINGS; ++Loop1UInt)
+  {
+    IrInitialValue[Loop1UInt] = 0ll;
+    IrFinalValue[Loop1UInt]   = 0ll;
+    IrResultValue[Loop1UInt]  = 0ll;
+    IrLevel[Loop1UInt]        = 2;
+  }
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=input_string() */
+/* ------------------------------------------------------------------ *\
+                       Read a string from stdin.
+\* ------------------------------------------------------------------ */
+void input_string(UCHAR *String)
+{
+  int8_t DataInput;
+
+  UINT8 Loop1UInt8;
+
+
+  Loop1UInt8 = 0;
+  do
+  {
+    DataInput = getchar_timeout_us(0);
+
+    switch (DataInput)
+    {
+      case (PICO_ERROR_TIMEOUT):
+        /* Input buffer is empty, sleep until next event (infrared bursts keep being captured by their ISR meanwhile). */
+        event_wait();
+        continue;
+      break;
+
+      case (0):
+        continue;
+      break;
+
+      case (8):
+        /* <Backspace> */
+        if (Loop1UInt8 > 0)
+        {
+          --Loop1UInt8;
+          String[Loop1UInt8] = 0x00;
+          printf("%c %c", 0x08, 0x08);  // erase character under the cursor.
+        }
+      break;
+
+      case (0x0D):
+        /* <Enter> */
+        if (Loop1UInt8 == 0)
+        {
+          String[Loop1UInt8++] = (UCHAR)DataInput;  
+          String[Loop1UInt8++] = 0x00;
+        }
+        printf("\r");
+      break;
+
+      default:
+        printf("%c", (UCHAR)DataInput);
+        String[Loop1UInt8] = (UCHAR)DataInput;
+        // printf("Loop1UInt8: %3u   %2.2X - %c\r", Loop1UInt8, DataInput, DataInput);  ///
+        ++Loop1UInt8;
+      break;
+    }
+  } while((Loop1UInt8 < 128) && (DataInput != 0x0D));
+  
+  String[Loop1UInt8] = '\0';  // end-of-string
+
+  /***
+  for (Loop1UInt8 = 0; Loop1UInt8 < 10; ++Loop1UInt8)
+    printf("%2u:[%2.2X]   ", Loop1UInt8, String[Loop1UInt8]);
+  printf("\r");
+  ***/
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=irp_menu() */
+/* ------------------------------------------------------------------ *\
+     IRP notation sub-menu: define a protocol at runtime, decode the
+      last infrared burst and send commands with it, without having
+                       to rebuild the firmware.
+\* ------------------------------------------------------------------ */
+void irp_menu(void)
+{
+  UCHAR String[130];
+
+  UINT8 Loop1UInt8;
+  UINT8 Repeat;
+
+  UINT16 ErrorPosition;
+  UINT16 Loop1UInt16;
+  UINT16 StepCount;
+
+  UINT32 Variable[IRP_VARIABLES];
+
+  static UINT32 Duration[(MAX_IR_READINGS / 2) + 1];  // too big for stack.
+
+
+  while (1)
+  {
+    printf("\r\r");
+    display_header();
+    printf("\r");
+    printf("     Current IRP string: %s\r", (IrpString[0]) ? (char *)IrpString : "none");
+    printf("\r");
+    printf("     1) Enter an IRP string.\r");
+    printf("     2) Decode last infrared burst with IRP string.\r");
+    printf("     3) Encode and send a command with IRP string.\r");
+    printf("\r");
+    printf("        Enter an option (or <Enter> to return to main menu): ");
+    input_string(String);
+    if (String[0] == 0x0D) return;
+    printf("\r\r");
+
+    if ((atoi(String) > 1) && (IrpString[0] == 0x00))
+    {
+      printf("No IRP string has been entered yet...\r\r");
+      continue;
+    }
+
+
+    switch (atoi(String))
+    {
+      case (1):
+        printf("Example (NEC1): {38.4k,564}<1,-1|1,-3>(16,-8,D:8,S:8,F:8,~F:8,1,^108m,(16,-4,1,^108m)*)\r\r");
+        printf("Enter IRP string: ");
+        input_string(String);
+        if (String[0] == 0x0D) break;
+
+        ErrorPosition = irp_compile(String, &IrpProgram);
+        if (ErrorPosition)
+        {
+          printf("\r%s\r%*s^\r", String, ErrorPosition - 1, "");
+          printf("Invalid or unsupported IRP string at position %u...\r\r", ErrorPosition);
+          IrpString[0] = 0x00;
+          break;
+        }
+        strcpy(IrpString, String);
+
+        printf("\rCarrier: %lu Hz   Unit: %.1f usec   Bit order: %s   Operations: %u\r", IrpProgram.CarrierFrequency, IrpProgram.Unit, (IrpProgram.FlagMsb) ? "msb first" : "lsb first", IrpProgram.OpTotal);
+        printf("Variables:");
+        for (Loop1UInt8 = 0; Loop1UInt8 < IRP_VARIABLES; ++Loop1UInt8)
+          if (IrpProgram.VariableUsed & (1ul << Loop1UInt8)) printf(" %c", 'A' + Loop1UInt8);
+        printf("\r\r");
+      break;
+
+      case (2):
+        if (IrStepCount == 0)
+        {
+          printf("No infrared burst has been received yet...\r\r");
+          break;
+        }
+
+        if (irp_decode(&IrpProgram, IrResultValue, IrStepCount, Variable))
+        {
+          printf("Last infrared burst (%u steps) doesn't match IRP string...\r\r", IrStepCount);
+          break;
+        }
+
+        printf("Last infrared burst (%u steps) decoded:", IrStepCount);
+        for (Loop1UInt8 = 0; Loop1UInt8 < IRP_VARIABLES; ++Loop1UInt8)
+          if (IrpProgram.VariableUsed & (1ul << Loop1UInt8)) printf("   %c = 0x%lX", 'A' + Loop1UInt8, Variable[Loop1UInt8]);
+        printf("\r\r");
+      break;
+
+      case (3):
+        for (Loop1UInt8 = 0; Loop1UInt8 < IRP_VARIABLES; ++Loop1UInt8)
+        {
+          Variable[Loop1UInt8] = 0;
+          if ((IrpProgram.VariableUsed & (1ul << Loop1UInt8)) == 0) continue;
+          printf("Enter %c (hexadecimal): ", 'A' + Loop1UInt8);
+          input_string(String);
+          Variable[Loop1UInt8] = strtoul(String, NULL, 16);
+        }
+        printf("Enter number of repeats (0 to 9): ");
+        input_string(String);
+        Repeat = atoi(String);
+        if (Repeat > 9) Repeat = 9;
+
+        StepCount = irp_encode(&IrpProgram, Variable, Repeat, Duration, sizeof(Duration) / sizeof(Duration[0]));
+        if (StepCount == 0)
+        {
+          printf("\rBurst would be longer than %u steps...\r\r", sizeof(Duration) / sizeof(Duration[0]));
+          break;
+        }
+
+        printf("\r%u steps:\r", StepCount);
+        for (Loop1UInt16 = 0; Loop1UInt16 < StepCount; ++Loop1UInt16)
+          printf("%5lu%s", Duration[Loop1UInt16], ((Loop1UInt16 % 12) == 11) ? "\r" : " ");
+        printf("\r\r");
+
+        if (transmit_burst(Duration, StepCount, IrpProgram.CarrierFrequency))
+          printf("Infrared transmitter is busy... try again later.\r\r");
+        else
+          printf("Sending %u steps at %lu Hz through infrared transmitter on GPIO %u.\r\r", StepCount, IrpProgram.CarrierFrequency, IR_TX);
+      break;
+
+      default:
+        printf("           Invalid choice... please re-enter [%s]\r\r", String);
+      break;
+    }
+  }
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=isr_signal_trap() */
+/* ----------------------------------------------------------------- *\
+         Interrupt handler for signal received from IR sensor
+                           (type VS1838B).
+\* ----------------------------------------------------------------- */
+gpio_irq_callback_t isr_signal_trap(UINT8 gpio, UINT32 Events)
+{
+  UINT64 Code;
+
+
+  if (gpio == IR_RX)
+  {
+    /* Keep every edge in the pre-trigger ring (except our own infrared light), even when the capture arrays are not ready for it. */
+    if ((Events & (GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL)) && (time_us_64() >= IrReceiveMaskEnd))
+    {
+      PretriggerRing[PretriggerHead % PRETRIGGER_EDGES].Time  = time_us_32();
+      PretriggerRing[PretriggerHead % PRETRIGGER_EDGES].Level = (Events & GPIO_IRQ_EDGE_FALL) ? 0 : 1;
+      ++PretriggerHead;
+    }
+
+    /* Ignore our own infrared light while (and shortly after) the infrared transmitter is sending a burst,
+       and make sure we never write past the end of the arrays, whatever the length of the burst. */
+    if ((time_us_64() < IrReceiveMaskEnd) || (IrStepCount >= (MAX_IR_READINGS - 1)))
+    {
+      gpio_acknowledge_irq(IR_RX, Events);
+      Events = 0;  // nothing to process.
+    }
+
+
+    /* IR line goes from Low to High. */
+    if (Events & GPIO_IRQ_EDGE_RISE)
+    {
+      IrFinalValue[IrStepCount]       = time_us_64();                                                       // this is the final timer value for current Low level.
+      IrResultValue[IrStepCount]      = (UINT32)(IrFinalValue[IrStepCount] - IrInitialValue[IrStepCount]);  // calculate duration of current Low level.
+      IrLevel[IrStepCount]            = 0;                                                                  // identify  as Low level.
+      IrInitialValue[IrStepCount + 1] = IrFinalValue[IrStepCount];                                          // this is also start timer of next High level.
+      ++IrStepCount;                                                                                        // start next logic level change (once its start timer is valid).
+
+      gpio_acknowledge_irq(IR_RX, GPIO_IRQ_EDGE_RISE);
+   }
+
+
+    /* IR line goes from High to Low. */
+    if (Events & GPIO_IRQ_EDGE_FALL)
+    {
+      if (IrStepCount > 0)
+      {
+        IrFinalValue[IrStepCount]       =  time_us_64();                                                      // this is the final timer value for current High level.
+        IrResultValue[IrStepCount]      = (UINT32)(IrFinalValue[IrStepCount] - IrInitialValue[IrStepCount]);  // calculate duration of current High level.
+        IrLevel[IrStepCount]            = 1;                                                                  // identify as High level.
+        IrInitialValue[IrStepCount + 1] = IrFinalValue[IrStepCount];                                          // this is also start timer of next Low level.
+        ++IrStepCount;                                                                                        // start next logic level change (once its start timer is valid).
+
+        /* A separator means that a new frame begins with the Low level starting now. */
+        if (IrResultValue[IrStepCount - 1] > IrProtocol.Separator) IrFrameStart = IrStepCount;
+
+        /* High level of last data bit just ended: deliver the frame to the application right away. */
+        if ((IrStepCount - IrFrameStart) == (2 + (IrProtocol.NumberOfBits * 2)))
+        {
+          if ((decode_ir_data(&IrResultValue[IrFrameStart], IrStepCount - IrFrameStart, &Code) == 0) && ir_event_dispatch(&IrProtocol, Code, IrInitialValue[IrFrameStart]))
+            event_post(EVENT_IR_FRAME);  // wake up application if it is sleeping in event_wait() on an empty queue.
+        }
+      }
+      else
+      {
+        IrInitialValue[IrStepCount]     = time_us_64();                                                       // start timer of first Low level.
+        PretriggerTrigger               = PretriggerHead - 1;                                                 // this edge triggers the capture.
+      }
+
+      gpio_acknowledge_irq(IR_RX, GPIO_IRQ_EDGE_FALL);
+    }
+
+
+    /* Burst will be complete when no more edge is received for a while. Re-arm the alarm that will tell it. */
+    if (Events)
+    {
+      if (BurstAlarmId > 0) cancel_alarm(BurstAlarmId);
+      BurstAlarmId = add_alarm_in_us(BURST_COMPLETE_TIME, burst_callback, NULL, true);
+    }
+  }
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=key_callback() */
+/* ------------------------------------------------------------------ *\
+     Callback posting EVENT_KEY_INPUT when characters are available
+                  on stdin (USB CDC or UART).
+\* ------------------------------------------------------------------ */
+void key_callback(void *Param)
+{
+  event_post(EVENT_KEY_INPUT);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=learn_capture() */
+/* ------------------------------------------------------------------ *\
+     Wait for next infrared burst during a learning session and decode
+       it with the protocol descriptor. Returns 0 when a frame has been
+     decoded, 1 when the burst doesn't fit the protocol and 2 when <s>
+     or <Esc> has been pressed on the console (returned in Key). Other
+                            keys are ignored.
+\* ------------------------------------------------------------------ */
+UINT8 learn_capture(UINT64 *Code, int16_t *Key)
+{
+  init_burst_variables();
+  while (burst_complete() == 0)
+  {
+    event_wait();
+    *Key = getchar_timeout_us(0);
+    if ((*Key == 's') || (*Key == 'S') || (*Key == 0x1B)) return 2;
+  }
+  recent_capture_add();  // decodes the burst too.
+
+  *Code = RecentCapture[(RecentTotal - 1) % RECENT_CAPTURES].Code;
+
+  return (RecentCapture[(RecentTotal - 1) % RECENT_CAPTURES].FlagDecoded) ? 0 : 1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=learn_session() */
+/* ------------------------------------------------------------------ *\
+      Guided bulk-learning session. Every button name of a list (the
+     template of the remote control file or names entered by the user)
+     is asked in turn. Each button must be pressed twice and is recorded
+       in the button list only when both presses decode to the same
+                              command.
+\* ------------------------------------------------------------------ */
+void learn_session(void)
+{
+  static UCHAR NameList[LEARN_MAX_NAMES][64];  // too big for stack.
+
+  UCHAR String[256];
+  UCHAR *Token;
+
+  UINT8 Attempt;
+  UINT8 FlagStop;
+  UINT8 Loop1UInt8;
+  UINT8 NameTotal;
+  UINT8 Status;
+
+  UINT16 LearnCount;
+  UINT16 Loop1UInt16;
+  UINT16 SkipCount;
+
+  int16_t Key;
+
+  UINT64 Code[2];
+  UINT64 StartTime;
+
+
+  /* Initializations. */
+  FlagStop   = FLAG_OFF;
+  LearnCount = 0;
+  NameTotal  = 0;
+  SkipCount  = 0;
+
+
+  printf("     1) Use button names of %s.\r", REMOTE_FILENAME);
+  printf("     2) Enter a list of button names (separated by commas).\r");
+  printf("\r");
+  printf("        Enter an option (or <Enter> to return to main menu): ");
+  input_string(String);
+  printf("\r");
+
+  switch (atoi(String))
+  {
+    case (1):
+      for (NameTotal = 0; (NameTotal < LEARN_MAX_NAMES) && (ButtonTemplate[NameTotal] != NULL); ++NameTotal)
+        strcpy(NameList[NameTotal], ButtonTemplate[NameTotal]);
+    break;
+
+    case (2):
+      printf("Button names: ");
+      input_string(String);
+      if (String[0] == 0x0D) return;
+      for (Token = strtok(String, ","); (Token != NULL) && (NameTotal < LEARN_MAX_NAMES); Token = strtok(NULL, ","))
+      {
+        while (*Token == ' ') ++Token;  // skip leading blanks.
+        if (*Token == 0x00) continue;
+        strncpy(NameList[NameTotal], Token, sizeof(NameList[0]) - 1);
+        NameList[NameTotal][sizeof(NameList[0]) - 1] = 0x00;
+        ++NameTotal;
+      }
+    break;
+
+    default:
+    return;
+  }
+
+  if (NameTotal == 0)
+  {
+    printf("No button name to learn...\r\r");
+    return;
+  }
+
+
+  display_header();
+  printf("Learning %u buttons for protocol %s.\r", NameTotal, IrProtocol.Name);
+  printf("Press every button twice when asked; press <s> on the console to skip a button or <Esc> to end the session.\r\r");
+  StartTime = time_us_64();
+
+  for (Loop1UInt8 = 0; (Loop1UInt8 < NameTotal) && (FlagStop == FLAG_OFF); ++Loop1UInt8)
+  {
+    if (RemoteDataTotal >= MAX_BUTTONS)
+    {
+      printf("Button list is full.\r");
+      break;
+    }
+
+    for (Attempt = 0; Attempt < LEARN_MAX_ATTEMPTS; ++Attempt)
+    {
+      printf("[%2u / %2u] %-20s press 1: ", Loop1UInt8 + 1, NameTotal, NameList[Loop1UInt8]);
+      Status = learn_capture(&Code[0], &Key);
+      if (Status != 2) recent_capture_name(NameList[Loop1UInt8]);
+      if (Status == 0)
+      {
+        printf("0x%8.8llX   press 2: ", Code[0]);
+        Status = learn_capture(&Code[1], &Key);
+        if (Status != 2) recent_capture_name(NameList[Loop1UInt8]);
+      }
+
+      if (Status == 2)
+      {
+        /* <s> skips this button, <Esc> ends the session. */
+        printf("%s\r", (Key == 0x1B) ? "session ended" : "skipped");
+        if (Key == 0x1B) FlagStop = FLAG_ON;
+        ++SkipCount;
+        break;
+      }
+
+      if (Status == 1)
+      {
+        printf("doesn't fit protocol %s, try again.\r", IrProtocol.Name);
+        continue;
+      }
+
+      if (Code[0] != Code[1])
+      {
+        printf("0x%8.8llX does not match, try again.\r", Code[1]);
+        continue;
+      }
+
+      /* Both presses match, warn if the same command has already been recorded under another name. */
+      for (Loop1UInt16 = 0; Loop1UInt16 < RemoteDataTotal; ++Loop1UInt16)
+        if (RemoteData[Loop1UInt16].CommandId == Code[0]) break;
+
+      strcpy(RemoteData[RemoteDataTotal].ButtonName, NameList[Loop1UInt8]);
+      RemoteData[RemoteDataTotal].CommandId = Code[0];
+      ++RemoteDataTotal;
+      ++LearnCount;
+      if (Loop1UInt16 < (RemoteDataTotal - 1))
+        printf("0x%8.8llX   recorded (same command as %s)\r", Code[1], RemoteData[Loop1UInt16].ButtonName);
+      else
+        printf("0x%8.8llX   recorded\r", Code[1]);
+      tone(10);
+      break;
+    }
+
+    if (Attempt >= LEARN_MAX_ATTEMPTS)
+    {
+      printf("          %s skipped after %u attempts.\r", NameList[Loop1UInt8], LEARN_MAX_ATTEMPTS);
+      ++SkipCount;
+    }
+  }
+
+  printf("\r");
+  printf("%u buttons recorded, %u skipped in %llu seconds.\r", LearnCount, SkipCount, (time_us_64() - StartTime) / 1000000ll);
+  printf("%s\r\r", Separator);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=macro_callback() */
+/* ------------------------------------------------------------------ *\
+       Timer callback sending the commands of the macro-command being
+       played. Each call sends one command and re-schedules itself for
+         the next one, so that the main loop (and infrared capture)
+                  keep running while a macro is played.
+\* ------------------------------------------------------------------ */
+int64_t macro_callback(alarm_id_t AlarmId, void *UserData)
+{
+  UINT16 StepCount;
+
+  UINT64 Delay;
+
+
+  if (MacroActive == MACRO_IDLE) return 0;
+
+  /* Infrared transmitter is still sending something else, check again a bit later. */
+  if (transmit_busy()) return -MACRO_RETRY_TIME;
+
+
+  /* Send current command of the macro. */
+  StepCount = encode_ir_frame(Macro[MacroActive].Step[MacroStep].CommandId, MacroDuration);
+  if (transmit_burst(MacroDuration, StepCount, IrProtocol.CarrierFrequency)) return -MACRO_RETRY_TIME;  // main loop claimed the transmitter in-between.
+  Delay = (TransmitEndTime - TransmitStartTime) + (Macro[MacroActive].Step[MacroStep].Delay * 1000ll);
+
+
+  /* Move on to next repetition or next command. */
+  if (++MacroRepeat >= Macro[MacroActive].Step[MacroStep].Repeat)
+  {
+    MacroRepeat = 0;
+    if (++MacroStep >= Macro[MacroActive].StepTotal)
+    {
+      /* This was the last command of the macro. */
+      MacroActive = MACRO_IDLE;
+      return 0;
+    }
+  }
+
+  /* Negative value: next call is relative to now (that is, the beginning of this transmission). */
+  return -(int64_t)Delay;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=macro_menu() */
+/* ------------------------------------------------------------------ *\
+     Macro-command sub-menu. Macro-commands are built from buttons
+     already recorded in the button list. They are played when their
+          trigger button is received in translator mode.
+\* ------------------------------------------------------------------ */
+void macro_menu(void)
+{
+  UCHAR String[128];
+
+  UINT8 Loop1UInt8;
+  UINT8 Loop2UInt8;
+
+  UINT16 ButtonIndex;
+
+  int32_t Value;
+
+
+  while (1)
+  {
+    printf("\r\r");
+    display_header();
+    printf("\r");
+    printf("Number of macro-commands defined: %u\r\r", MacroTotal);
+    printf("     1) Define a new macro-command from the button list.\r");
+    printf("     2) Display macro-commands.\r");
+    printf("     3) Start translator mode (macro-commands are played when their button is received).\r");
+    printf("\r");
+    printf("        Enter an option (or <Enter> to return to main menu): ");
+    input_string(String);
+    if (String[0] == 0x0D) return;
+
+
+    switch (atoi(String))
+    {
+      case (1):
+        printf("\r\r");
+        display_button_list();
+
+        if (MacroTotal >= MAX_MACROS)
+        {
+          printf("No more room for macro-commands.\r\r");
+          break;
+        }
+
+        printf("Enter button number that will trigger the macro-command: ");
+        input_string(String);
+        ButtonIndex = atoi(String);
+        if ((String[0] == 0x0D) || (ButtonIndex >= RemoteDataTotal))
+        {
+          printf("\rInvalid button number... macro-command not added.\r\r");
+          break;
+        }
+        Macro[MacroTotal].TriggerId = RemoteData[ButtonIndex].CommandId;
+        Macro[MacroTotal].StepTotal = 0;
+
+        for (Loop1UInt8 = 0; Loop1UInt8 < MAX_MACRO_STEPS; ++Loop1UInt8)
+        {
+          printf("\rCommand %u - enter button number to send (or <Enter> to end macro-command): ", Loop1UInt8 + 1);
+          input_string(String);
+          if (String[0] == 0x0D) break;
+          ButtonIndex = atoi(String);
+          if (ButtonIndex >= RemoteDataTotal)
+          {
+            printf("Invalid button number...\r");
+            --Loop1UInt8;
+            continue;
+          }
+          Macro[MacroTotal].Step[Loop1UInt8].CommandId = RemoteData[ButtonIndex].CommandId;
+
+          printf("Number of times to send %s (1 to 255): ", RemoteData[ButtonIndex].ButtonName);
+          input_string(String);
+          Value = (String[0] == 0x0D) ? 1 : atoi(String);
+          if ((Value < 1) || (Value > 0xFF))
+          {
+            printf("Invalid number of times...\r");
+            --Loop1UInt8;
+            continue;
+          }
+          Macro[MacroTotal].Step[Loop1UInt8].Repeat = Value;
+
+          printf("Delay after each transmission (in msec, 0 to 65535): ");
+          input_string(String);
+          Value = (String[0] == 0x0D) ? 0 : atoi(String);
+          if ((Value < 0) || (Value > 0xFFFF))
+          {
+            printf("Invalid delay...\r");
+            --Loop1UInt8;
+            continue;
+          }
+          Macro[MacroTotal].Step[Loop1UInt8].Delay = Value;
+
+          ++Macro[MacroTotal].StepTotal;
+        }
+
+        if (Macro[MacroTotal].StepTotal)
+          ++MacroTotal;
+        else
+          printf("\rEmpty macro-command... not added.\r\r");
+      break;
+
+      case (2):
+        printf("\r\r");
+        for (Loop1UInt8 = 0; Loop1UInt8 < MacroTotal; ++Loop1UInt8)
+        {
+          printf("[%2u] Trigger: 0x%8.8llX\r", Loop1UInt8, Macro[Loop1UInt8].TriggerId);
+          for (Loop2UInt8 = 0; Loop2UInt8 < Macro[Loop1UInt8].StepTotal; ++Loop2UInt8)
+            printf("         Send 0x%8.8llX  %3u time(s)  delay %5u msec\r", Macro[Loop1UInt8].Step[Loop2UInt8].CommandId, Macro[Loop1UInt8].Step[Loop2UInt8].Repeat, Macro[Loop1UInt8].Step[Loop2UInt8].Delay);
+        }
+        printf("%s\r\r", Separator);
+      break;
+
+      case (3):
+        printf("\r\r");
+        translate_run();
+      break;
+
+      default:
+        printf("\r\r");
+        printf("           Invalid choice... please re-enter [%s]\r\r", String);
+      break;
+    }
+  }
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=macro_start() */
+/* ------------------------------------------------------------------ *\
+        Start playing a macro-command in background. Returns 1 if
+               another macro-command is already being played.
+\* ------------------------------------------------------------------ */
+UINT8 macro_start(UINT8 MacroNumber)
+{
+  if (MacroActive != MACRO_IDLE) return 1;
+
+  MacroStep   = 0;
+  MacroRepeat = 0;
+  MacroActive = MacroNumber;
+
+  /* First command is sent right away from the timer callback, which will then re-schedule itself. */
+  add_alarm_in_us(1, macro_callback, NULL, true);
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=pretrigger_copy() */
+/* ------------------------------------------------------------------ *\
+     Prepend the edges of the pre-trigger window to the main capture
+      arrays (the same way sampler_copy() replaces them), so that every
+     menu working on last burst received (timing, decoding, frames...)
+     sees what preceded it. The copy begins with a Low level, so that
+      Low levels remain on even steps, and the oldest edges are left
+              out when the whole would exceed MAX_IR_READINGS.
+\* ------------------------------------------------------------------ */
+void pretrigger_copy(void)
+{
+  UINT16 Loop1UInt16;
+  UINT16 PreCount;
+
+  UINT32 First;
+  UINT32 Trigger;
+  UINT32 TriggerTime;
+
+  UINT64 TriggerTime64;
+
+
+  if (pretrigger_find(&First, &Trigger))
+  {
+    printf("Pre-trigger edges of last burst are not available.\r\r");
+    return;
+  }
+  if (PretriggerCopied == Trigger)
+  {
+    printf("Pre-trigger edges have already been copied to the main capture.\r\r");
+    return;
+  }
+
+  /* Keep the most recent edges that fit, starting with a Low level. */
+  if ((Trigger - First) > (UINT32)(MAX_IR_READINGS - IrStepCount)) First = Trigger - (MAX_IR_READINGS - IrStepCount);
+  if ((First < Trigger) && (PretriggerRing[First % PRETRIGGER_EDGES].Level != 0)) ++First;
+  PreCount = Trigger - First;
+  if (PreCount == 0)
+  {
+    printf("No edge to copy in the pre-trigger window.\r\r");
+    return;
+  }
+
+
+  /* Make room at the beginning of the main capture. */
+  for (Loop1UInt16 = IrStepCount; Loop1UInt16 > 0; --Loop1UInt16)
+  {
+    IrInitialValue[Loop1UInt16 - 1 + PreCount] = IrInitialValue[Loop1UInt16 - 1];
+    IrFinalValue[Loop1UInt16 - 1 + PreCount]   = IrFinalValue[Loop1UInt16 - 1];
+    IrResultValue[Loop1UInt16 - 1 + PreCount]  = IrResultValue[Loop1UInt16 - 1];
+    IrLevel[Loop1UInt16 - 1 + PreCount]        = IrLevel[Loop1UInt16 - 1];
+  }
+
+  /* Ring times are 32 bits: rebuild 64-bit timer values from the first edge of the burst. */
+  TriggerTime   = PretriggerRing[Trigger % PRETRIGGER_EDGES].Time;
+  TriggerTime64 = IrInitialValue[PreCount];
+  for (Loop1UInt16 = 0; Loop1UInt16 < PreCount; ++Loop1UInt16)
+  {
+    IrInitialValue[Loop1UInt16] = TriggerTime64 - (TriggerTime - PretriggerRing[(First + Loop1UInt16) % PRETRIGGER_EDGES].Time);
+    IrFinalValue[Loop1UInt16]   = TriggerTime64 - (TriggerTime - PretriggerRing[(First + Loop1UInt16 + 1) % PRETRIGGER_EDGES].Time);
+    IrResultValue[Loop1UInt16]  = (UINT32)(IrFinalValue[Loop1UInt16] - IrInitialValue[Loop1UInt16]);
+    IrLevel[Loop1UInt16]        = PretriggerRing[(First + Loop1UInt16) % PRETRIGGER_EDGES].Level;
+  }
+  IrStepCount     += PreCount;
+  PretriggerCopied = Trigger;
+
+  printf("%u pre-trigger steps prepended to the main capture (%u steps now).\r\r", PreCount, IrStepCount);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=pretrigger_display() */
+/* ------------------------------------------------------------------ *\
+     Display the edges received during the pre-trigger window that
+     precedes the first edge of last burst (preamble glitches, previous
+      frames, etc...). The ring keeps running while the burst itself is
+     being received, so that only the edges not yet overwritten can be
+                              displayed.
+\* ------------------------------------------------------------------ */
+void pretrigger_display(void)
+{
+  UINT8 Status;
+
+  UINT16 LineCount;
+
+  UINT32 EdgeCount;
+  UINT32 First;
+  UINT32 Loop1UInt32;
+  UINT32 Oldest;
+  UINT32 Trigger;
+  UINT32 TriggerTime;
+  UINT32 Duration;
+
+
+  /* Initializations. */
+  LineCount = 50;  // number of lines per page.
+
+
+  Status = pretrigger_find(&First, &Trigger);
+  if (Status == 1)
+  {
+    printf("No infrared burst has been received yet...\r\r");
+    return;
+  }
+  if (Status == 2)
+  {
+    printf("Pre-trigger edges of last burst have been overwritten (more than %u edges received since).\r\r", PRETRIGGER_EDGES);
+    return;
+  }
+  Oldest      = (PretriggerHead > PRETRIGGER_EDGES) ? (PretriggerHead - PRETRIGGER_EDGES) : 0;
+  TriggerTime = PretriggerRing[Trigger % PRETRIGGER_EDGES].Time;
+  EdgeCount   = Trigger - First;
+
+  display_header();
+  printf("Pre-trigger window: %u msec before first edge of last burst (button: %s)\r", PretriggerWindow, ButtonName);
+  printf("%lu edges received", EdgeCount);
+  if ((First == Oldest) && (Oldest > 0)) printf(" (ring wrapped, older edges are lost)");
+  printf("\r\r");
+  if (EdgeCount == 0)
+  {
+    printf("Infrared line was idle during the whole pre-trigger window.\r");
+    printf("%s\r\r", Separator);
+    return;
+  }
+
+  printf(" Edge     Time before    Logic   Duration\r");
+  printf("number  burst (usec)     level     (usec)\r\r");
+  for (Loop1UInt32 = First; Loop1UInt32 < Trigger; ++Loop1UInt32)
+  {
+    if (((Loop1UInt32 - First) % LineCount) == 0 && (Loop1UInt32 != First)) printf("to be continued\r%s\r\r", Separator);
+
+    Duration = PretriggerRing[(Loop1UInt32 + 1) % PRETRIGGER_EDGES].Time - PretriggerRing[Loop1UInt32 % PRETRIGGER_EDGES].Time;
+    printf(" %5ld     %9lu     %4s     %6lu", (long)Loop1UInt32 - (long)Trigger, TriggerTime - PretriggerRing[Loop1UInt32 % PRETRIGGER_EDGES].Time, LevelString[PretriggerRing[Loop1UInt32 % PRETRIGGER_EDGES].Level], Duration);
+
+    /* Help identify what preceded the burst. */
+    if ((PretriggerRing[Loop1UInt32 % PRETRIGGER_EDGES].Level == 1) && (Duration > IrProtocol.Separator))
+      printf("   <separator>");
+    else if ((PretriggerRing[Loop1UInt32 % PRETRIGGER_EDGES].Level == 0) && (Duration > ((IrProtocol.HeaderLow * (100 - PROTOCOL_TOLERANCE)) / 100)) && (Duration < ((IrProtocol.HeaderLow * (100 + PROTOCOL_TOLERANCE)) / 100)))
+      printf("   <get ready>");
+    else if (Duration < RAW_GLITCH_TIME)
+      printf("   <glitch>");
+    printf("\r");
+  }
+  printf("%s\r\r", Separator);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=pretrigger_find() */
+/* ------------------------------------------------------------------ *\
+     Find the ring edges of the pre-trigger window preceding last burst:
+     First is the oldest edge inside the window, Trigger the first edge
+       of the burst. Returns 0 when found, 1 when no burst has been
+        received yet and 2 when the edges have been overwritten.
+\* ------------------------------------------------------------------ */
+UINT8 pretrigger_find(UINT32 *First, UINT32 *Trigger)
+{
+  UINT32 Oldest;
+  UINT32 TriggerTime;
+
+
+  *Trigger = PretriggerTrigger;
+  if (*Trigger == 0xFFFFFFFF) return 1;
+
+  Oldest = (PretriggerHead > PRETRIGGER_EDGES) ? (PretriggerHead - PRETRIGGER_EDGES) : 0;
+  if (*Trigger < Oldest) return 2;
+
+
+  /* Go back in the ring as long as the edges are inside the pre-trigger window. */
+  TriggerTime = PretriggerRing[*Trigger % PRETRIGGER_EDGES].Time;
+  *First      = *Trigger;
+  while ((*First > Oldest) && ((TriggerTime - PretriggerRing[(*First - 1) % PRETRIGGER_EDGES].Time) <= (PretriggerWindow * 1000ul))) --*First;
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=pretrigger_menu() */
+/* ------------------------------------------------------------------ *\
+                   Pre-trigger ring buffer sub-menu.
+\* ------------------------------------------------------------------ */
+void pretrigger_menu(void)
+{
+  UCHAR String[128];
+
+  UINT32 Window;
+
+
+  while (1)
+  {
+    printf("\r\r");
+    display_header();
+    printf("\r");
+    printf("     1) Display edges received before last burst.\r");
+    printf("     2) Change pre-trigger window (currently %u msec).\r", PretriggerWindow);
+    printf("     3) Prepend edges received before last burst to the main capture.\r");
+    printf("\r");
+    printf("        Enter an option (or <Enter> to return to main menu): ");
+    input_string(String);
+    if (String[0] == 0x0D) return;
+    printf("\r\r");
+
+
+    switch (atoi(String))
+    {
+      case (1):
+        pretrigger_display();
+      break;
+
+      case (2):
+        printf("Enter pre-trigger window (1 to 60000 msec): ");
+        input_string(String);
+        Window = atoi(String);
+        if ((Window == 0) || (Window > 60000))
+        {
+          printf("\rInvalid pre-trigger window...\r\r");
+          break;
+        }
+        PretriggerWindow = Window;
+      break;
+
+      case (3):
+        pretrigger_copy();
+      break;
+
+      default:
+        printf("           Invalid choice... please re-enter [%s]\r\r", String);
+      break;
+    }
+  }
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=profile_timing() */
+/* ------------------------------------------------------------------ *\
+      Accumulate many presses of the same button and display mean,
+       min, max and standard deviation of every step, so that the
+     thresholds of a protocol may be chosen from data. Statistics are
+      computed on the fly (Welford), so memory use does not depend on
+      the number of presses. Every press is decoded: a press giving
+      another command or another step count than the first one (other
+     button, repeat frames, glitch) would mix unrelated durations in
+                     the same step and is rejected.
+\* ------------------------------------------------------------------ */
+void profile_timing(void)
+{
+  UCHAR String[128];
+
+  UINT8 FlagStop;
+  UINT8 ReferenceStatus;
+  UINT8 Status;
+
+  UINT16 BurstCount;
+  UINT16 BurstTotal;
+  UINT16 LineCount;
+  UINT16 Loop1UInt16;
+  UINT16 RejectCount;
+  UINT16 StepTotal;
+
+  UINT64 Code;
+  UINT64 ReferenceCode;
+
+  float StdDev;
+
+
+  /* Initializations. */
+  LineCount   = 50;  // number of lines per page.
+  RejectCount = 0;
+  StepTotal   = 0;
+
+
+  printf("Enter button name for this timing profile: ");
+  input_string(ButtonName);
+  printf("Enter number of presses to accumulate (1 to %u): ", MAX_PROFILE_BURSTS);
+  input_string(String);
+  BurstTotal = atoi(String);
+  if ((BurstTotal == 0) || (BurstTotal > MAX_PROFILE_BURSTS))
+  {
+    printf("\rInvalid number of presses...\r\r");
+    return;
+  }
+
+  for (Loop1UInt16 = 0; Loop1UInt16 < MAX_IR_READINGS; ++Loop1UInt16)
+  {
+    Profile[Loop1UInt16].Count = 0;
+    Profile[Loop1UInt16].Mean  = 0.0f;
+    Profile[Loop1UInt16].M2    = 0.0f;
+    Profile[Loop1UInt16].Min   = 0xFFFFFFFF;
+    Profile[Loop1UInt16].Max   = 0;
+  }
+
+
+  /* Accumulate bursts. */
+  printf("\r");
+  for (BurstCount = 0; BurstCount < BurstTotal; ++BurstCount)
+  {
+    init_burst_variables();
+    printf("Press button %s on remote control (%u / %u), or any key to stop: ", ButtonName, BurstCount + 1, BurstTotal);
+    FlagStop = FLAG_OFF;
+    while (burst_complete() == 0)
+    {
+      event_wait();
+      if (getchar_timeout_us(0) != PICO_ERROR_TIMEOUT)
+      {
+        FlagStop = FLAG_ON;
+        break;
+      }
+    }
+    if (FlagStop) break;
+
+    /* First press is the reference: the others must decode the same way and have the same step count. */
+    Status = segment_decode(IrResultValue, IrStepCount, &Code);
+    if (BurstCount == 0)
+    {
+      ReferenceStatus = Status;
+      ReferenceCode   = Code;
+    }
+    else if ((Status != ReferenceStatus) || (Code != ReferenceCode) || (IrStepCount != StepTotal))
+    {
+      if (Status == 0)
+        printf("0x%8.8llX   %u steps   rejected (first press: %u steps)\r", Code, IrStepCount, StepTotal);
+      else
+        printf("undecoded   %u steps   rejected (first press: %u steps)\r", IrStepCount, StepTotal);
+      ++RejectCount;
+      --BurstCount;  // ask for this press again.
+      continue;
+    }
+
+    printf("%u steps\r", IrStepCount);
+    profile_update();
+    StepTotal = IrStepCount;
+  }
+  printf("\r\r");
+
+
+  /* Display statistics of every step. */
+  for (Loop1UInt16 = 0; Loop1UInt16 < StepTotal; ++Loop1UInt16)
+  {
+    if ((Loop1UInt16 % LineCount) == 0)
+    {
+      if (Loop1UInt16) printf("to be continued\r%s\r\r", Separator);
+      display_header();
+      printf("Timing profile of button: %s (%u presses, %u rejected)\r\r", ButtonName, BurstCount, RejectCount);
+      printf(" Step   Logic   Count      Mean       Min       Max    Std dev\r");
+      printf("number  level\r\r");
+    }
+
+    StdDev = (Profile[Loop1UInt16].Count > 1) ? sqrtf(Profile[Loop1UInt16].M2 / (Profile[Loop1UInt16].Count - 1)) : 0.0f;
+    printf("  %3u   %4s    %4u    %7.1f     %5lu     %5lu    %7.1f\r", Loop1UInt16 + 1, LevelString[Loop1UInt16 % 2], Profile[Loop1UInt16].Count, Profile[Loop1UInt16].Mean, Profile[Loop1UInt16].Min, Profile[Loop1UInt16].Max, StdDev);
+  }
+  printf("%s\r\r", Separator);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=profile_update() */
+/* ------------------------------------------------------------------ *\
+     Add the durations of last infrared burst to the timing profile
+               (Welford's streaming mean and variance).
+\* ------------------------------------------------------------------ */
+void profile_update(void)
+{
+  UINT16 Loop1UInt16;
+
+  float Delta;
+  float Value;
+
+
+  for (Loop1UInt16 = 0; Loop1UInt16 < IrStepCount; ++Loop1UInt16)
+  {
+    Value = (float)IrResultValue[Loop1UInt16];
+
+    ++Profile[Loop1UInt16].Count;
+    Delta = Value - Profile[Loop1UInt16].Mean;
+    Profile[Loop1UInt16].Mean += Delta / Profile[Loop1UInt16].Count;
+    Profile[Loop1UInt16].M2   += Delta * (Value - Profile[Loop1UInt16].Mean);
+
+    if (IrResultValue[Loop1UInt16] < Profile[Loop1UInt16].Min) Profile[Loop1UInt16].Min = IrResultValue[Loop1UInt16];
+    if (IrResultValue[Loop1UInt16] > Profile[Loop1UInt16].Max) Profile[Loop1UInt16].Max = IrResultValue[Loop1UInt16];
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=raw_learn() */
+/* ------------------------------------------------------------------ *\
+           Learn last infrared burst received as raw timing.
+\* ------------------------------------------------------------------ */
+void raw_learn(void)
+{
+  UCHAR String[128];
+
+
+  if (IrStepCount == 0)
+  {
+    printf("No infrared burst has been received yet...\r\r");
+    return;
+  }
+
+  if (RawDataTotal >= MAX_RAW_BUTTONS)
+  {
+    printf("No more room for buttons learned raw.\r\r");
+    return;
+  }
+
+
+  printf("Enter button name for this raw infrared burst [%s]: ", ButtonName);
+  input_string(String);
+  String[sizeof(ButtonName) - 1] = 0x00;  // make sure button name fits.
+  if ((String[0] != 0x00) && (String[0] != 0x0D))
+    strcpy(ButtonName, String);
+  recent_capture_name(ButtonName);
+
+  strcpy(RawData[RawDataTotal].ButtonName, ButtonName);
+  /* VS1838b removes the carrier: use the one measured on IR_CARRIER, otherwise assume the most common one. */
+  RawData[RawDataTotal].CarrierFrequency = (CarrierMeasured) ? CarrierMeasured : TRANSMIT_CARRIER_DEFAULT;
+  RawData[RawDataTotal].StepCount        = raw_normalize(IrResultValue, IrStepCount, RawData[RawDataTotal].Duration);
+
+  printf("\r");
+  printf("Button %s learned raw: %u steps received, %u steps kept after normalization.\r\r", RawData[RawDataTotal].ButtonName, IrStepCount, RawData[RawDataTotal].StepCount);
+  ++RawDataTotal;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=raw_menu() */
+/* ------------------------------------------------------------------ *\
+                     Raw learn / replay sub-menu.
+\* ------------------------------------------------------------------ */
+void raw_menu(void)
+{
+  UCHAR String[128];
+
+  UINT8 ButtonIndex;
+  UINT8 Loop1UInt8;
+
+  UINT16 Loop1UInt16;
+
+
+  while (1)
+  {
+    printf("\r\r");
+    display_header();
+    printf("\r");
+    printf("Number of buttons learned raw: %u\r\r", RawDataTotal);
+    printf("     1) Learn last infrared burst raw.\r");
+    printf("     2) Display buttons learned raw.\r");
+    printf("     3) Replay a button learned raw.\r");
+    printf("\r");
+    printf("        Enter an option (or <Enter> to return to main menu): ");
+    input_string(String);
+    if (String[0] == 0x0D) return;
+
+
+    switch (atoi(String))
+    {
+      case (1):
+        printf("\r\r");
+        raw_learn();
+      break;
+
+      case (2):
+        printf("\r\r");
+        for (Loop1UInt8 = 0; Loop1UInt8 < RawDataTotal; ++Loop1UInt8)
+        {
+          printf("[%2u] %16s   %3u steps   %5lu Hz:", Loop1UInt8, RawData[Loop1UInt8].ButtonName, RawData[Loop1UInt8].StepCount, RawData[Loop1UInt8].CarrierFrequency);
+          for (Loop1UInt16 = 0; Loop1UInt16 < RawData[Loop1UInt8].StepCount; ++Loop1UInt16)
+          {
+            if ((Loop1UInt16 % 16) == 0) printf("\r     ");
+            printf(" %c%lu", (Loop1UInt16 % 2) ? '-' : '+', RawData[Loop1UInt8].Duration[Loop1UInt16]);
+          }
+          printf("\r\r");
+        }
+        printf("%s\r\r", Separator);
+      break;
+
+      case (3):
+        printf("\r\r");
+        printf("Enter number of the button to replay: ");
+        input_string(String);
+        ButtonIndex = atoi(String);
+        if ((String[0] == 0x0D) || (ButtonIndex >= RawDataTotal))
+        {
+          printf("\rInvalid button number...\r\r");
+          break;
+        }
+
+        if (transmit_burst(RawData[ButtonIndex].Duration, RawData[ButtonIndex].StepCount, RawData[ButtonIndex].CarrierFrequency))
+          printf("\rInfrared transmitter is busy... try again later.\r\r");
+        else
+          printf("\rSending %s (%u steps at %lu Hz).\r\r", RawData[ButtonIndex].ButtonName, RawData[ButtonIndex].StepCount, RawData[ButtonIndex].CarrierFrequency);
+      break;
+
+      default:
+        printf("\r\r");
+        printf("           Invalid choice... please re-enter [%s]\r\r", String);
+      break;
+    }
+  }
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=raw_normalize() */
+/* ------------------------------------------------------------------ *\
+        Remove glitches from an infrared burst and quantize its
+     durations so that a raw capture replays cleanly. A step shorter
+     than RAW_GLITCH_TIME is merged with the step before and the step
+      after it (both of the other logic level), then every duration
+     is rounded to a multiple of RAW_QUANTUM. Returns the number of
+                          steps kept in Target.
+\* ------------------------------------------------------------------ */
+UINT16 raw_normalize(volatile UINT32 *Source, UINT16 StepCount, UINT32 *Target)
+{
+  UINT16 Loop1UInt16;
+  UINT16 TargetCount;
+
+
+  /* Glitch removal. */
+  TargetCount = 0;
+  for (Loop1UInt16 = 0; Loop1UInt16 < StepCount; ++Loop1UInt16)
+  {
+    if ((Source[Loop1UInt16] < RAW_GLITCH_TIME) && (TargetCount > 0) && ((Loop1UInt16 + 1) < StepCount))
+    {
+      Target[TargetCount - 1] += Source[Loop1UInt16] + Source[Loop1UInt16 + 1];
+      ++Loop1UInt16;  // following step has been merged too.
+      continue;
+    }
+
+    if (TargetCount >= MAX_RAW_STEPS) break;
+    Target[TargetCount++] = Source[Loop1UInt16];
+  }
+
+
+  /* Duration quantization. */
+  for (Loop1UInt16 = 0; Loop1UInt16 < TargetCount; ++Loop1UInt16)
+  {
+    Target[Loop1UInt16] = ((Target[Loop1UInt16] + (RAW_QUANTUM / 2)) / RAW_QUANTUM) * RAW_QUANTUM;
+    if (Target[Loop1UInt16] == 0) Target[Loop1UInt16] = RAW_QUANTUM;
+  }
+
+  return TargetCount;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=recent_capture_add() */
+/* ------------------------------------------------------------------ *\
+     Keep a copy of last infrared burst in the recent captures (the
+     oldest one is overwritten). The button name is left empty: it is
+     entered after the burst has been received (see recent_capture_name()).
+\* ------------------------------------------------------------------ */
+void recent_capture_add(void)
+{
+  UINT8 Index;
+
+  UINT16 Loop1UInt16;
+
+
+  Index = RecentTotal % RECENT_CAPTURES;
+
+  RecentCapture[Index].ButtonName[0] = 0x00;
+  RecentCapture[Index].FlagDecoded = (segment_decode(IrResultValue, IrStepCount, &RecentCapture[Index].Code) == 0);
+  RecentCapture[Index].StepCount   = (IrStepCount < MAX_RECENT_STEPS) ? IrStepCount : MAX_RECENT_STEPS;
+  for (Loop1UInt16 = 0; Loop1UInt16 < RecentCapture[Index].StepCount; ++Loop1UInt16)
+    RecentCapture[Index].Duration[Loop1UInt16] = (IrResultValue[Loop1UInt16] > 0xFFFF) ? 0xFFFF : IrResultValue[Loop1UInt16];
+
+  ++RecentTotal;
+
+  return;
+}
+
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=recent_capture_name() */
+/* ------------------------------------------------------------------ *\
+         Give a name to the most recent capture, once the user has
+                entered it for the burst just received.
+\* ------------------------------------------------------------------ */
+void recent_capture_name(UCHAR *Name)
+{
+  if (RecentTotal == 0) return;
+
+  strncpy(RecentCapture[(RecentTotal - 1) % RECENT_CAPTURES].ButtonName, Name, sizeof(RecentCapture[0].ButtonName) - 1);
+  RecentCapture[(RecentTotal - 1) % RECENT_CAPTURES].ButtonName[sizeof(RecentCapture[0].ButtonName) - 1] = 0x00;
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=replay_ir_burst() */
+/* ------------------------------------------------------------------ *\
+   Replay last infrared burst received through the infrared transmitter.
+\* ------------------------------------------------------------------ */
+void replay_ir_burst(void)
+{
+  UCHAR String[128];
+
+  UINT32 CarrierFrequency;
+
+
+  if (IrStepCount == 0)
+  {
+    printf("No infrared burst has been received yet...\r");
+    printf("You must first press a button on the remote control before selecting this menu choice.\r\r");
+    printf("Press <Enter> to return to menu: ");
+
+    input_string(String);
+
+    return;
+  }
+
+
+  /* Infrared burst always begins with a Low level from VS1838b (that is, a Mark from the remote control). */
+  CarrierFrequency = (CarrierMeasured) ? CarrierMeasured : TRANSMIT_CARRIER_DEFAULT;
+  if (transmit_burst(IrResultValue, IrStepCount, CarrierFrequency))
+  {
+    printf("Infrared transmitter is busy... try again later.\r\r");
+  }
+  else
+  {
+    printf("Sending %u steps at %lu Hz through infrared transmitter on GPIO %u.\r\r", IrStepCount, CarrierFrequency, IR_TX);
+  }
+
+  return;
+}
+
+
+
+
+
+#ifdef USE_FREERTOS
+/* $PAGE */
+/* $TITLE=rtos_start() */
+/* ------------------------------------------------------------------ *\
+      Create FreeRTOS queues and tasks, and start the scheduler.
+      Capture task is pinned to core 0 (where the infrared ISR and the
+     burst alarm run), decode and console tasks to core 1. Never returns.
+\* ------------------------------------------------------------------ */
+void rtos_start(void)
+{
+  BurstDropCount = 0;
+  BurstQueue     = xQueueCreate(RTOS_BURST_QUEUE_SIZE,  sizeof(struct burst_message));
+  DecodeQueue    = xQueueCreate(RTOS_DECODE_QUEUE_SIZE, sizeof(struct decode_message));
+
+  xTaskCreate(capture_task, "Capture", RTOS_STACK_SIZE, NULL, RTOS_CAPTURE_PRIORITY, &CaptureTaskHandle);
+  vTaskCoreAffinitySet(CaptureTaskHandle, (1 << 0));
+
+  xTaskCreate(decode_task,  "Decode",  RTOS_STACK_SIZE, NULL, RTOS_DECODE_PRIORITY,  &DecodeTaskHandle);
+  vTaskCoreAffinitySet(DecodeTaskHandle,  (1 << 1));
+
+  xTaskCreate(console_task, "Console", RTOS_STACK_SIZE, NULL, RTOS_CONSOLE_PRIORITY, &ConsoleTaskHandle);
+  vTaskCoreAffinitySet(ConsoleTaskHandle, (1 << 1));
+
+  vTaskStartScheduler();
+}
+#endif  // USE_FREERTOS
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=sampler_capture() */
+/* ------------------------------------------------------------------ *\
+     Capture next burst on every infrared receiver at once. The PIO
+     state machine pushes a word each time one of the GPIOs changes
+      and DMA copies them into the ring buffer; this function follows
+      the DMA write pointer and splits the words into one edge stream
+     per receiver, all of them timed by the same counter. Capture ends
+      when no edge has been received for BURST_COMPLETE_TIME.
+\* ------------------------------------------------------------------ */
+void sampler_capture(void)
+{
+  UCHAR String[128];
+
+  UINT8 Changed;
+  UINT8 Channel;
+  UINT8 FlagFirst;
+  UINT8 Levels;
+  UINT8 PreviousLevels;
+
+  UINT16 ReadIndex;
+  UINT16 WriteIndex;
+
+  UINT32 Counter;
+  UINT32 PreviousCounter;
+  UINT32 Word;
+
+  UINT64 LastWordTime;
+  UINT64 Time;
+
+
+  /* Initializations. */
+  FlagFirst       = FLAG_ON;
+  LastWordTime    = 0ll;
+  PreviousCounter = 0;
+  PreviousLevels  = 0;
+  ReadIndex       = 0;
+  Time            = 0ll;
+  for (Channel = 0; Channel < SAMPLER_CHANNELS; ++Channel)
+  {
+    SamplerChannel[Channel].FlagStarted = FLAG_OFF;
+    SamplerChannel[Channel].StepCount   = 0;
+  }
+
+
+  printf("     1) Standard resolution (1 usec).\r");
+  printf("     2) High resolution (%u system clock cycles, %lu nsec).\r", ir_sampler_CYCLES_PER_SAMPLE, (UINT32)((ir_sampler_CYCLES_PER_SAMPLE * 1000000000ll) / clock_get_hz(clk_sys)));
+  printf("\r");
+  printf("        Enter an option [1]: ");
+  input_string(String);
+  sampler_set_rate((String[0] == '2') ? SAMPLER_RATE_HIGH : SAMPLER_RATE);
+  printf("\r");
+
+  printf("Infrared receivers expected on GPIO %u to %u, %.1f nsec per tick.\r", SAMPLER_PIN_BASE, SAMPLER_PIN_BASE + SAMPLER_CHANNELS - 1, SamplerTick);
+  printf("Press a button on the remote control (or any key on the console to cancel)...\r\r");
+
+  /* Restart the state machine with a previous sample that can't match the GPIOs, so that the first word gives their initial level. */
+  pio_sm_set_enabled(SAMPLER_PIO, SamplerStateMachine, false);
+  pio_sm_clear_fifos(SAMPLER_PIO, SamplerStateMachine);
+  pio_sm_restart(SAMPLER_PIO, SamplerStateMachine);
+  pio_sm_exec(SAMPLER_PIO, SamplerStateMachine, pio_encode_mov_not(pio_x, pio_null));
+  pio_sm_exec(SAMPLER_PIO, SamplerStateMachine, pio_encode_mov(pio_osr, pio_null));
+  pio_sm_exec(SAMPLER_PIO, SamplerStateMachine, pio_encode_jmp(SamplerOffset));
+  dma_channel_set_write_addr(SamplerDmaChannel, SamplerRing, false);
+  dma_channel_set_trans_count(SamplerDmaChannel, 0xFFFFFFFF, true);
+  pio_sm_set_enabled(SAMPLER_PIO, SamplerStateMachine, true);
+
+  while (1)
+  {
+    WriteIndex = (UINT16)(((UINT32)dma_channel_hw_addr(SamplerDmaChannel)->write_addr - (UINT32)SamplerRing) / sizeof(SamplerRing[0]));
+    WriteIndex %= (sizeof(SamplerRing) / sizeof(SamplerRing[0]));
+
+    if (ReadIndex == WriteIndex)
+    {
+      if ((LastWordTime) && ((time_us_64() - LastWordTime) > BURST_COMPLETE_TIME)) break;
+      if ((LastWordTime == 0ll) && (getchar_timeout_us(0) != PICO_ERROR_TIMEOUT)) break;
+      continue;
+    }
+
+    Word      = SamplerRing[ReadIndex];
+    ReadIndex = (ReadIndex + 1) % (sizeof(SamplerRing) / sizeof(SamplerRing[0]));
+    Levels    = (UINT8)(Word >> 28);
+    Counter   = Word & 0x0FFFFFFF;
+
+    if (FlagFirst)
+    {
+      /* Initial level of every GPIO. */
+      PreviousLevels  = Levels;
+      PreviousCounter = Counter;
+      FlagFirst       = FLAG_OFF;
+      continue;
+    }
+
+    /* Counter goes down by one every tick (28 bits, wraps around). */
+    Time           += (PreviousCounter - Counter) & 0x0FFFFFFF;
+    PreviousCounter = Counter;
+    Changed         = (Levels ^ PreviousLevels) & ((1 << SAMPLER_CHANNELS) - 1);
+    PreviousLevels  = Levels;
+    LastWordTime    = time_us_64();
+
+    for (Channel = 0; Channel < SAMPLER_CHANNELS; ++Channel)
+    {
+      if ((Changed & (1 << Channel)) == 0) continue;
+
+      if (SamplerChannel[Channel].FlagStarted == FLAG_OFF)
+      {
+        SamplerChannel[Channel].FlagStarted = FLAG_ON;
+        SamplerChannel[Channel].FirstEdge   = Time;
+      }
+      else if (SamplerChannel[Channel].StepCount < SAMPLER_MAX_STEPS)
+      {
+        SamplerChannel[Channel].Duration[SamplerChannel[Channel].StepCount++] = (UINT32)(Time - SamplerChannel[Channel].LastEdge);
+      }
+      SamplerChannel[Channel].LastEdge = Time;
+    }
+  }
+  pio_sm_set_enabled(SAMPLER_PIO, SamplerStateMachine, false);
+  dma_channel_abort(SamplerDmaChannel);
+
+  if (LastWordTime == 0ll) return;
+
+  sampler_display();
+
+  /* Other menus (timing, decoding, histogram...) work on the main capture arrays. */
+  printf("Enter a receiver number to copy it to the main capture (or <Enter> to return to menu): ");
+  input_string(String);
+  if ((String[0] >= '0') && (String[0] < ('0' + SAMPLER_CHANNELS))) sampler_copy(String[0] - '0');
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=sampler_copy() */
+/* ------------------------------------------------------------------ *\
+     Copy the edge stream of one receiver into the main capture arrays,
+     each duration being converted from counter ticks to usec (rounded),
+      so that every menu working on last burst received may be used.
+\* ------------------------------------------------------------------ */
+void sampler_copy(UINT8 Channel)
+{
+  UINT16 Loop1UInt16;
+  UINT16 StepCount;
+
+
+  StepCount = (SamplerChannel[Channel].StepCount < MAX_IR_READINGS) ? SamplerChannel[Channel].StepCount : MAX_IR_READINGS;
+
+  init_burst_variables();
+  for (Loop1UInt16 = 0; Loop1UInt16 < StepCount; ++Loop1UInt16)
+  {
+    IrResultValue[Loop1UInt16] = (UINT32)(((SamplerChannel[Channel].Duration[Loop1UInt16] * SamplerTick) + 500.0f) / 1000.0f);
+    IrLevel[Loop1UInt16]       = Loop1UInt16 % 2;  // receivers are idle High, first step is always Low.
+  }
+  IrStepCount = StepCount;
+
+  printf("\r%u steps of receiver %u copied to the main capture.\r\r", StepCount, Channel);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=sampler_display() */
+/* ------------------------------------------------------------------ *\
+     Display the edge streams of every infrared receiver side by side,
+     along with the delay of the first edge of each receiver compared
+       to the first one. Durations differing by more than
+         DIFF_TOLERANCE percent from the first receiver are flagged.
+\* ------------------------------------------------------------------ */
+void sampler_display(void)
+{
+  UCHAR Flag;
+
+  UINT8 Channel;
+
+  UINT16 LineCount;
+  UINT16 Loop1UInt16;
+  UINT16 StepTotal;
+
+  UINT32 Difference;
+
+
+  /* Initializations. */
+  LineCount = 50;  // number of lines per page.
+  StepTotal = 0;
+
+
+  display_header();
+  printf("Multi-receiver capture of button: %s (durations in usec, %.1f nsec resolution)\r\r", ButtonName, SamplerTick);
+  for (Channel = 0; Channel < SAMPLER_CHANNELS; ++Channel)
+  {
+    printf("Receiver %u on GPIO %2u: %3u steps", Channel, SAMPLER_PIN_BASE + Channel, SamplerChannel[Channel].StepCount);
+    if (SamplerChannel[Channel].FlagStarted && SamplerChannel[0].FlagStarted)
+      printf("   first edge %+.2f usec from receiver 0\r", ((float)((int64_t)(SamplerChannel[Channel].FirstEdge - SamplerChannel[0].FirstEdge)) * SamplerTick) / 1000.0f);
+    else
+      printf("   no edge\r");
+    if (SamplerChannel[Channel].StepCount > StepTotal) StepTotal = SamplerChannel[Channel].StepCount;
+  }
+  printf("\r");
+
+
+  for (Loop1UInt16 = 0; Loop1UInt16 < StepTotal; ++Loop1UInt16)
+  {
+    if ((Loop1UInt16 % LineCount) == 0)
+    {
+      if (Loop1UInt16) printf("to be continued\r%s\r\r", Separator);
+      printf(" Step   Logic");
+      for (Channel = 0; Channel < SAMPLER_CHANNELS; ++Channel)
+        printf("   Receiver %u", Channel);
+      printf("\rnumber  level\r\r");
+    }
+
+    printf("  %3u   %4s ", Loop1UInt16 + 1, LevelString[Loop1UInt16 % 2]);
+    for (Channel = 0; Channel < SAMPLER_CHANNELS; ++Channel)
+    {
+      if (Loop1UInt16 >= SamplerChannel[Channel].StepCount)
+      {
+        printf("          ---");
+        continue;
+      }
+
+      /* Flag durations too different from receiver 0. */
+      Flag = ' ';
+      if ((Channel) && (Loop1UInt16 < SamplerChannel[0].StepCount))
+      {
+        Difference = (SamplerChannel[Channel].Duration[Loop1UInt16] > SamplerChannel[0].Duration[Loop1UInt16]) ? (SamplerChannel[Channel].Duration[Loop1UInt16] - SamplerChannel[0].Duration[Loop1UInt16]) : (SamplerChannel[0].Duration[Loop1UInt16] - SamplerChannel[Channel].Duration[Loop1UInt16]);
+        if ((Difference * 100) > (SamplerChannel[0].Duration[Loop1UInt16] * DIFF_TOLERANCE)) Flag = '*';
+      }
+      printf("    %8.2f%c", (SamplerChannel[Channel].Duration[Loop1UInt16] * SamplerTick) / 1000.0f, Flag);
+    }
+    printf("\r");
+  }
+  printf("%s\r\r", Separator);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=sampler_init() */
+/* ------------------------------------------------------------------ *\
+     Initialize the PIO state machine sampling several infrared
+       receivers, and the DMA channel copying its words into the ring
+      buffer (the write address wraps around every 2^SAMPLER_RING_BITS
+     bytes). Both remain stopped until a capture is started.
+\* ------------------------------------------------------------------ */
+void sampler_init(void)
+{
+  dma_channel_config DmaConfig;
+
+
+  SamplerOffset       = pio_add_program(SAMPLER_PIO, &ir_sampler_program);
+  SamplerStateMachine = pio_claim_unused_sm(SAMPLER_PIO, true);
+  ir_sampler_program_init(SAMPLER_PIO, SamplerStateMachine, SamplerOffset, SAMPLER_PIN_BASE, (float)SAMPLER_RATE);
+  sampler_set_rate(SAMPLER_RATE);
+
+  SamplerDmaChannel = dma_claim_unused_channel(true);
+  DmaConfig = dma_channel_get_default_config(SamplerDmaChannel);
+  channel_config_set_transfer_data_size(&DmaConfig, DMA_SIZE_32);
+  channel_config_set_read_increment(&DmaConfig, false);
+  channel_config_set_write_increment(&DmaConfig, true);
+  channel_config_set_ring(&DmaConfig, true, SAMPLER_RING_BITS);
+  channel_config_set_dreq(&DmaConfig, pio_get_dreq(SAMPLER_PIO, SamplerStateMachine, false));
+  dma_channel_configure(SamplerDmaChannel, &DmaConfig, SamplerRing, &SAMPLER_PIO->rxf[SamplerStateMachine], 0, false);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=sampler_set_rate() */
+/* ------------------------------------------------------------------ *\
+     Change the sample rate (counter tick) of the multi-receiver
+     capture. SAMPLER_RATE_HIGH runs the state machine at full system
+     clock speed, so that edges are timestamped to the nearest 10 system
+       clock cycles. SamplerTick keeps the resulting duration of one
+       tick, used to scale every duration when displaying or copying.
+\* ------------------------------------------------------------------ */
+void sampler_set_rate(UINT32 Rate)
+{
+  float ClockDivider;
+
+
+  if (Rate == SAMPLER_RATE_HIGH)
+    ClockDivider = 1.0f;
+  else
+    ClockDivider = (float)clock_get_hz(clk_sys) / (float)(Rate * ir_sampler_CYCLES_PER_SAMPLE);
+
+  pio_sm_set_clkdiv(SAMPLER_PIO, SamplerStateMachine, ClockDivider);
+  SamplerTick = (ClockDivider * ir_sampler_CYCLES_PER_SAMPLE * 1000000000.0f) / (float)clock_get_hz(clk_sys);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=segment_burst() */
+/* ------------------------------------------------------------------ *\
+     Split a burst into frames on idle gaps (High levels longer than
+     SegmentGap), so that two presses received in the same burst are
+        decoded separately, then label every frame:
+          FRAME_DATA:   complete frame decoded with the descriptor.
+          FRAME_REPEAT: same command as previous data frame, or short
+                        "get-ready" only frame (repeat code).
+          FRAME_HEADER: "get-ready" bit followed by unknown data.
+          FRAME_NOISE:  no "get-ready" bit.
+     Frames are written to the array supplied by the caller (MAX_FRAMES
+     entries), so that several tasks may segment bursts at the same time.
+                 Returns the number of frames found.
+\* ------------------------------------------------------------------ */
+UINT8 segment_burst(volatile UINT32 *Duration, UINT16 StepCount, struct burst_frame *Frame)
+{
+  UINT8 FrameTotal;
+  UINT8 LastData;
+  UINT8 Loop1UInt8;
+
+  UINT16 Loop1UInt16;
+  UINT16 Start;
+
+
+  /* Initializations. */
+  FrameTotal = 0;
+  Start      = 0;
+
+
+  for (Loop1UInt16 = 0; Loop1UInt16 <= StepCount; ++Loop1UInt16)
+  {
+    /* A frame ends with a High level (odd step) longer than the gap, or with the burst itself. */
+    if ((Loop1UInt16 < StepCount) && (((Loop1UInt16 % 2) == 0) || (Duration[Loop1UInt16] <= SegmentGap))) continue;
+
+    if ((Loop1UInt16 > Start) && (FrameTotal < MAX_FRAMES))
+    {
+      Frame[FrameTotal].Start     = Start;
+      Frame[FrameTotal].StepCount = Loop1UInt16 - Start;
+      ++FrameTotal;
+    }
+    Start = Loop1UInt16 + 1;
+  }
+
+
+  /* Label every frame. */
+  LastData = 0xFF;  // no data frame yet.
+  for (Loop1UInt8 = 0; Loop1UInt8 < FrameTotal; ++Loop1UInt8)
+  {
+    Frame[Loop1UInt8].FlagDecoded = (decode_ir_data(&Duration[Frame[Loop1UInt8].Start], Frame[Loop1UInt8].StepCount, &Frame[Loop1UInt8].Code) == 0);
+
+    if (Frame[Loop1UInt8].FlagDecoded)
+    {
+      Frame[Loop1UInt8].Type = ((LastData != 0xFF) && (Frame[LastData].Code == Frame[Loop1UInt8].Code)) ? FRAME_REPEAT : FRAME_DATA;
+      LastData = Loop1UInt8;
+    }
+    else if ((Duration[Frame[Loop1UInt8].Start] > ((IrProtocol.HeaderLow * (100 - PROTOCOL_TOLERANCE)) / 100)) && (Duration[Frame[Loop1UInt8].Start] < ((IrProtocol.HeaderLow * (100 + PROTOCOL_TOLERANCE)) / 100)))
+    {
+      Frame[Loop1UInt8].Type = (Frame[Loop1UInt8].StepCount <= 4) ? FRAME_REPEAT : FRAME_HEADER;
+    }
+    else
+    {
+      Frame[Loop1UInt8].Type = FRAME_NOISE;
+    }
+  }
+
+  return FrameTotal;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=segment_decode() */
+/* ------------------------------------------------------------------ *\
+     Segment a burst and return the command of its first data frame.
+     The first frame that decodes is always a data frame (a repeat needs
+      a data frame before it), so that frames are decoded one after the
+      other, on the same idle gaps as segment_burst(), until one of them
+      fits: nothing is shared between callers, and no frame is decoded
+                     after the one returned.
+      Returns 0 when a frame has been decoded, 1 otherwise (same as
+                         decode_ir_data()).
+\* ------------------------------------------------------------------ */
+UINT8 segment_decode(volatile UINT32 *Duration, UINT16 StepCount, UINT64 *Code)
+{
+  UINT16 Loop1UInt16;
+  UINT16 Start;
+
+
+  Start = 0;
+  for (Loop1UInt16 = 0; Loop1UInt16 <= StepCount; ++Loop1UInt16)
+  {
+    /* A frame ends with a High level (odd step) longer than the gap, or with the burst itself. */
+    if ((Loop1UInt16 < StepCount) && (((Loop1UInt16 % 2) == 0) || (Duration[Loop1UInt16] <= SegmentGap))) continue;
+
+    if ((Loop1UInt16 > Start) && (decode_ir_data(&Duration[Start], Loop1UInt16 - Start, Code) == 0)) return 0;
+    Start = Loop1UInt16 + 1;
+  }
+
+  *Code = 0ll;
+
+  return 1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=segment_display() */
+/* ------------------------------------------------------------------ *\
+                 Display the frames of last infrared burst.
+\* ------------------------------------------------------------------ */
+void segment_display(void)
+{
+  UCHAR *TypeName[4] = {"noise", "data", "repeat", "header"};
+
+  UINT8 FrameTotal;
+  UINT8 Loop1UInt8;
+
+  UINT16 Loop1UInt16;
+
+  UINT32 StartTime;
+
+  struct burst_frame Frame[MAX_FRAMES];
+
+
+  FrameTotal = segment_burst(IrResultValue, IrStepCount, Frame);
+
+  printf("\r");
+  printf("%u frame(s) in this burst (idle gap longer than %lu usec):\r\r", FrameTotal, SegmentGap);
+  printf("Frame   First   Steps     Start     Gap after    Type      Command\r");
+  printf("number   step              (usec)      (usec)\r\r");
+
+  StartTime = 0;
+  Loop1UInt16 = 0;
+  for (Loop1UInt8 = 0; Loop1UInt8 < FrameTotal; ++Loop1UInt8)
+  {
+    /* Time from the first edge of the burst. */
+    for (; Loop1UInt16 < Frame[Loop1UInt8].Start; ++Loop1UInt16) StartTime += IrResultValue[Loop1UInt16];
+
+    printf(" %3u     %3u     %3u   %9lu   ", Loop1UInt8, Frame[Loop1UInt8].Start, Frame[Loop1UInt8].StepCount, StartTime);
+    if ((Frame[Loop1UInt8].Start + Frame[Loop1UInt8].StepCount) < IrStepCount)
+      printf("  %9lu", IrResultValue[Frame[Loop1UInt8].Start + Frame[Loop1UInt8].StepCount]);
+    else
+      printf("        ---");
+    printf("    %-6s", TypeName[Frame[Loop1UInt8].Type]);
+    if (Frame[Loop1UInt8].FlagDecoded) printf("    0x%8.8llX", Frame[Loop1UInt8].Code);
+    printf("\r");
+  }
+  printf("%s\r\r", Separator);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=segment_menu() */
+/* ------------------------------------------------------------------ *\
+                     Frame segmentation sub-menu.
+\* ------------------------------------------------------------------ */
+void segment_menu(void)
+{
+  UCHAR String[128];
+
+  UINT32 Gap;
+
+
+  while (1)
+  {
+    printf("\r\r");
+    display_header();
+    printf("\r");
+    printf("     1) Display frames of last infrared burst.\r");
+    printf("     2) Change idle gap between frames (currently %lu usec).\r", SegmentGap);
+    printf("\r");
+    printf("        Enter an option (or <Enter> to return to main menu): ");
+    input_string(String);
+    if (String[0] == 0x0D) return;
+    printf("\r\r");
+
+
+    switch (atoi(String))
+    {
+      case (1):
+        if (IrStepCount == 0)
+          printf("No infrared burst has been received yet...\r\r");
+        else
+          segment_display();
+      break;
+
+      case (2):
+        printf("Enter idle gap between frames (in usec, protocol %s uses %lu): ", IrProtocol.Name, IrProtocol.Separator);
+        input_string(String);
+        Gap = atoi(String);
+        if ((Gap < IrProtocol.OneHigh) || (Gap >= BURST_COMPLETE_TIME))
+        {
+          printf("\rIdle gap must be longer than a data bit (%u usec) and shorter than the end of a burst (%u usec)...\r\r", IrProtocol.OneHigh, BURST_COMPLETE_TIME);
+          break;
+        }
+        SegmentGap = Gap;
+      break;
+
+      default:
+        printf("           Invalid choice... please re-enter [%s]\r\r", String);
+      break;
+    }
+  }
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=signature_compute() */
+/* ------------------------------------------------------------------ *\
+     Reduce the first frame of a burst to a 32-bit signature, in a
+     single pass over its durations. Durations are quantized relative
+     to the frame itself: every duration joins the first cluster of its
+     logic level whose reference (first duration of the cluster) is
+     within a factor of 1.5, or starts a new cluster. The cluster
+     numbers are hashed with FNV-1a. Nominal durations of a protocol
+     are much further apart than 1.5 times (550 / 1675 / 4450 usec for
+     Samsung) while timing errors stay well below, so that there is no
+     bucket edge near the durations actually received and every press
+     of a button gives the same signature. The frame ends at the first
+     High level longer than SegmentGap, so that repeat frames don't
+     change the signature.
+\* ------------------------------------------------------------------ */
+UINT32 signature_compute(volatile UINT32 *Duration, UINT16 StepCount)
+{
+  UINT8 Cluster;
+  UINT8 ClusterTotal[2];
+  UINT8 Level;
+
+  UINT16 Loop1UInt16;
+
+  UINT32 Reference[2][SIGNATURE_CLUSTERS];
+  UINT32 Signature;
+
+
+  ClusterTotal[0] = 0;
+  ClusterTotal[1] = 0;
+  Signature = SIGNATURE_FNV_OFFSET;
+  for (Loop1UInt16 = 0; Loop1UInt16 < StepCount; ++Loop1UInt16)
+  {
+    Level = Loop1UInt16 % 2;  // 0 = Low level (Mark), 1 = High level (Space).
+    if (Level && (Duration[Loop1UInt16] > SegmentGap)) break;  // idle gap: end of first frame.
+
+    for (Cluster = 0; Cluster < ClusterTotal[Level]; ++Cluster)
+      if (((Duration[Loop1UInt16] * 2) < (Reference[Level][Cluster] * 3)) && ((Duration[Loop1UInt16] * 3) > (Reference[Level][Cluster] * 2))) break;
+
+    if ((Cluster == ClusterTotal[Level]) && (Cluster < SIGNATURE_CLUSTERS))
+      Reference[Level][ClusterTotal[Level]++] = Duration[Loop1UInt16];  // new distinct duration (Cluster == SIGNATURE_CLUSTERS when there are too many).
+
+    Signature = (Signature ^ ((Level << 4) | Cluster)) * SIGNATURE_FNV_PRIME;
+  }
+
+  if (Signature == 0) Signature = 1;  // 0 marks an empty slot of the hash table.
+
+  return Signature;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=signature_find() */
+/* ------------------------------------------------------------------ *\
+       Find a signature in the signature hash table. Returns its slot,
+                           or -1 if unknown.
+\* ------------------------------------------------------------------ */
+int16_t signature_find(UINT32 Signature)
+{
+  UINT8 Loop1UInt8;
+  UINT8 Slot;
+
+
+  Slot = Signature & (SIGNATURE_TABLE_SIZE - 1);
+  for (Loop1UInt8 = 0; Loop1UInt8 < SIGNATURE_TABLE_SIZE; ++Loop1UInt8)
+  {
+    if (SignatureTable[Slot].Signature == Signature) return Slot;
+    if (SignatureTable[Slot].Signature == 0)         return -1;  // empty slot: end of the probe sequence.
+    Slot = (Slot + 1) & (SIGNATURE_TABLE_SIZE - 1);
+  }
+
+  return -1;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=signature_learn() */
+/* ------------------------------------------------------------------ *\
+     Add a signature and its button name to the signature hash table
+      (the name is replaced if the signature is already there). The
+      table is never filled completely, so that every probe sequence
+       ends on an empty slot. Returns 0 on success, 1 if it is full.
+\* ------------------------------------------------------------------ */
+UINT8 signature_learn(UINT32 Signature, UCHAR *ButtonName)
+{
+  int16_t Slot;
+
+
+  Slot = signature_find(Signature);
+  if (Slot < 0)
+  {
+    if (SignatureTotal >= ((SIGNATURE_TABLE_SIZE * 3) / 4)) return 1;
+
+    Slot = Signature & (SIGNATURE_TABLE_SIZE - 1);
+    while (SignatureTable[Slot].Signature != 0) Slot = (Slot + 1) & (SIGNATURE_TABLE_SIZE - 1);
+    SignatureTable[Slot].Signature = Signature;
+    ++SignatureTotal;
+  }
+
+  strncpy(SignatureTable[Slot].ButtonName, ButtonName, sizeof(SignatureTable[Slot].ButtonName) - 1);
+  SignatureTable[Slot].ButtonName[sizeof(SignatureTable[Slot].ButtonName) - 1] = 0x00;
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=signature_menu() */
+/* ------------------------------------------------------------------ *\
+     Raw signature sub-menu: learn buttons of a remote control whose
+      protocol can't be decoded, by their signature only (no raw
+       capture is kept), and recognize them when pressed again.
+\* ------------------------------------------------------------------ */
+void signature_menu(void)
+{
+  UCHAR Name[128];
+  UCHAR String[128];
+
+  UINT8 FlagStop;
+  UINT8 Loop1UInt8;
+  UINT8 Press;
+
+  int16_t Slot;
+
+  UINT32 Signature;
+
+
+  while (1)
+  {
+    printf("\r\r");
+    display_header();
+    printf("\r");
+    printf("     1) Learn buttons by raw signature (%u signatures learned).\r", SignatureTotal);
+    printf("     2) Recognize buttons pressed (until a key is pressed).\r");
+    printf("     3) Display signatures learned.\r");
+    printf("     4) Erase signatures learned.\r");
+    printf("\r");
+    printf("        Enter an option (or <Enter> to return to main menu): ");
+    input_string(String);
+    if (String[0] == 0x0D) return;
+    printf("\r\r");
+
+
+    switch (atoi(String))
+    {
+      case (1):
+        while (1)
+        {
+          printf("Enter button name (or <Enter> to end): ");
+          input_string(Name);
+          if (Name[0] == 0x0D) break;
+
+          printf("Press button <%s> %u times (or any key to cancel)...\r", Name, SIGNATURE_PRESSES);
+          for (Press = 0; Press < SIGNATURE_PRESSES; ++Press)
+          {
+            init_burst_variables();
+            FlagStop = FLAG_OFF;
+            while (burst_complete() == 0)
+            {
+              event_wait();
+              if (getchar_timeout_us(0) != PICO_ERROR_TIMEOUT)
+              {
+                FlagStop = FLAG_ON;
+                break;
+              }
+            }
+            if (FlagStop == FLAG_ON) break;
+
+            Signature = signature_compute(IrResultValue, IrStepCount);
+            if (signature_learn(Signature, Name))
+            {
+              printf("Signature table is full...\r\r");
+              break;
+            }
+            printf("   press %u: %3u steps, signature 0x%8.8lX\r", Press + 1, IrStepCount, Signature);
+          }
+          printf("\r");
+          if ((FlagStop == FLAG_ON) || (Press < SIGNATURE_PRESSES)) break;
+        }
+      break;
+
+      case (2):
+        printf("Press buttons on remote control (or any key to return to menu)...\r\r");
+        while (1)
+        {
+          init_burst_variables();
+          FlagStop = FLAG_OFF;
+          while (burst_complete() == 0)
+          {
+            event_wait();
+            if (getchar_timeout_us(0) != PICO_ERROR_TIMEOUT)
+            {
+              FlagStop = FLAG_ON;
+              break;
+            }
+          }
+          if (FlagStop == FLAG_ON) break;
+
+          Signature = signature_compute(IrResultValue, IrStepCount);
+          Slot      = signature_find(Signature);
+          printf("%3u steps   signature 0x%8.8lX   %s\r", IrStepCount, Signature, (Slot < 0) ? "unknown" : (char *)SignatureTable[Slot].ButtonName);
+        }
+        printf("\r");
+      break;
+
+      case (3):
+        printf("Signatures learned: %u\r\r", SignatureTotal);
+        printf("Slot   Signature   Button name\r");
+        for (Loop1UInt8 = 0; Loop1UInt8 < SIGNATURE_TABLE_SIZE; ++Loop1UInt8)
+          if (SignatureTable[Loop1UInt8].Signature)
+            printf(" %3u  0x%8.8lX   %s\r", Loop1UInt8, SignatureTable[Loop1UInt8].Signature, SignatureTable[Loop1UInt8].ButtonName);
+        printf("%s\r\r", Separator);
+      break;
+
+      case (4):
+        memset(SignatureTable, 0x00, sizeof(SignatureTable));
+        SignatureTotal = 0;
+        printf("Signatures learned have been erased.\r\r");
+      break;
+
+      default:
+        printf("           Invalid choice... please re-enter [%s]\r\r", String);
+      break;
+    }
+  }
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=tone() */
+/* ------------------------------------------------------------------ *\
+         Make a tone for the specified number of milliseconds on
+                             active buzzer.
+\* ------------------------------------------------------------------ */
+void tone(UINT16 MilliSeconds)
+{
+  gpio_put(BUZZER, 1);
+  sleep_ms(MilliSeconds);
+  gpio_put(BUZZER, 0);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=translate_menu() */
+/* ------------------------------------------------------------------ *\
+         Translator sub-menu. The translation table is built from
+       buttons already recorded in the button list: the source button
+       belongs to the remote control that we have, the target button
+     to the remote control that we want to emulate. A target of another
+     protocol (see IrProtocolTable) is entered as address and command
+                      and sent with that protocol.
+\* ------------------------------------------------------------------ */
+void translate_menu(void)
+{
+  UCHAR String[128];
+
+  UINT16 Loop1UInt16;
+  UINT16 SourceIndex;
+  UINT16 TargetIndex;
+
+  UINT32 Address;
+  UINT32 Command;
+
+  const struct ir_protocol *Protocol;
+
+
+  while (1)
+  {
+    printf("\r\r");
+    display_header();
+    printf("\r");
+    printf("Number of entries in translation table: %u\r\r", TranslateTotal);
+    printf("     1) Add a translation (source button -> target button) from the button list.\r");
+    printf("     2) Display translation table.\r");
+    printf("     3) Start translator (press any key to stop).\r");
+    printf("\r");
+    printf("        Enter an option (or <Enter> to return to main menu): ");
+    input_string(String);
+    if (String[0] == 0x0D) return;
+
+
+    switch (atoi(String))
+    {
+      case (1):
+        printf("\r\r");
+        display_button_list();
+
+        if (TranslateTotal >= MAX_BUTTONS)
+        {
+          printf("Translation table is full.\r\r");
+          break;
+        }
+
+        printf("Enter button number of the remote control being received: ");
+        input_string(String);
+        SourceIndex = atoi(String);
+        if (SourceIndex >= RemoteDataTotal)
+        {
+          printf("\rInvalid button number... translation not added.\r\r");
+          break;
+        }
+
+        /* Target command comes from the button list with our own protocol, or is entered for another protocol. */
+        printf("Enter protocol of the remote control to emulate [%s]: ", IrProtocol.Name);
+        input_string(String);
+        if (String[0] == 0x0D)
+        {
+          printf("Enter button number of the remote control to emulate: ");
+          input_string(String);
+          TargetIndex = atoi(String);
+          if (TargetIndex >= RemoteDataTotal)
+          {
+            printf("\rInvalid button number... translation not added.\r\r");
+            break;
+          }
+          TranslateTable[TranslateTotal].TargetId       = RemoteData[TargetIndex].CommandId;
+          TranslateTable[TranslateTotal].TargetProtocol = &IrProtocol;
+        }
+        else
+        {
+          Protocol = ir_protocol_find(String);
+          if (Protocol == NULL)
+          {
+            printf("\rUnknown protocol... translation not added.\r\r");
+            break;
+          }
+          printf("Enter address (hexadecimal, %u bits): ", Protocol->AddressBits);
+          input_string(String);
+          Address = strtoul(String, NULL, 16);
+          printf("Enter command (hexadecimal, %u bits): ", Protocol->CommandBits);
+          input_string(String);
+          Command = strtoul(String, NULL, 16);
+          TranslateTable[TranslateTotal].TargetId       = ir_encode_code(Protocol, Address, Command);
+          TranslateTable[TranslateTotal].TargetProtocol = Protocol;
+        }
+
+        TranslateTable[TranslateTotal].SourceId = RemoteData[SourceIndex].CommandId;
+        printf("\r%s (0x%8.8llX) -> %s 0x%8.8llX added.\r\r", RemoteData[SourceIndex].ButtonName, RemoteData[SourceIndex].CommandId, TranslateTable[TranslateTotal].TargetProtocol->Name, TranslateTable[TranslateTotal].TargetId);
+        ++TranslateTotal;
+      break;
+
+      case (2):
+        printf("\r\r");
+        printf("        Source command          Target command   Target protocol\r\r");
+        for (Loop1UInt16 = 0; Loop1UInt16 < TranslateTotal; ++Loop1UInt16)
+          printf("[%3u]       0x%8.8llX     ->     0x%8.8llX       %s\r", Loop1UInt16, TranslateTable[Loop1UInt16].SourceId, TranslateTable[Loop1UInt16].TargetId, TranslateTable[Loop1UInt16].TargetProtocol->Name);
+        printf("%s\r\r", Separator);
+      break;
+
+      case (3):
+        printf("\r\r");
+        translate_run();
+      break;
+
+      default:
+        printf("\r\r");
+        printf("           Invalid choice... please re-enter [%s]\r\r", String);
+      break;
+    }
+  }
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=translate_run() */
+/* ------------------------------------------------------------------ *\
+       Translate infrared bursts from one remote control to another
+      until a key is pressed. The frame is decoded as soon as the High
+     level of its last data bit has been received (that is, on the
+     falling edge of the stop bit) and the target frame is sent right
+     away. Latency is measured from the first edge received to the
+           first edge sent by the infrared transmitter.
+       A button bound to a macro-command starts it in background instead.
+\* ------------------------------------------------------------------ */
+void translate_run(void)
+{
+  UINT8  FlagFound;
+
+  UINT16 FrameSteps;
+  UINT16 Loop1UInt16;
+  UINT16 StepCount;
+
+  UINT32 Latency;
+  UINT32 LatencyMax;
+  UINT32 LatencyMin;
+  UINT32 TranslateCount;
+
+  UINT64 Code;
+  UINT64 FirstEdgeTime;
+  UINT64 LatencyTotal;
+
+  static UINT32 Duration[(MAX_IR_READINGS / 2) + 1];  // too big for stack.
+
+
+  /* Initializations. */
+  FrameSteps     = 2 + (IrProtocol.NumberOfBits * 2);  // steps needed by decode_ir_data().
+  LatencyMax     = 0;
+  LatencyMin     = 0xFFFFFFFF;
+  LatencyTotal   = 0ll;
+  TranslateCount = 0;
+
+
+  printf("Translator started with protocol %s... press any key to stop.\r\r", IrProtocol.Name);
+  init_burst_variables();
+
+  while (getchar_timeout_us(0) == PICO_ERROR_TIMEOUT)
+  {
+    /* Wait for a complete frame, or for a separator ending an incomplete one. */
+    StepCount = IrStepCount;
+    if (StepCount == 0) continue;
+    if ((StepCount < FrameSteps) && ((time_us_64() - IrInitialValue[StepCount]) < IrProtocol.Separator)) continue;
+
+
+    FirstEdgeTime = IrInitialValue[0];
+    if (decode_ir_data(IrResultValue, StepCount, &Code) == 0)
+    {
+      /* Macro-commands have priority over translation table. */
+      for (Loop1UInt16 = 0; Loop1UInt16 < MacroTotal; ++Loop1UInt16)
+      {
+        if (Macro[Loop1UInt16].TriggerId == Code) break;
+      }
+
+      if (Loop1UInt16 < MacroTotal)
+      {
+        if (macro_start(Loop1UInt16))
+          printf("0x%8.8llX -> macro-command %u ignored (another one is being played)\r", Code, Loop1UInt16);
+        else
+          printf("0x%8.8llX -> macro-command %u started\r", Code, Loop1UInt16);
+      }
+      else if (MacroActive != MACRO_IDLE)
+      {
+        printf("0x%8.8llX -> ignored while a macro-command is being played\r", Code);
+      }
+      else
+      {
+        /* Find the command in translation table. */
+        FlagFound = FLAG_OFF;
+        for (Loop1UInt16 = 0; Loop1UInt16 < TranslateTotal; ++Loop1UInt16)
+        {
+          if (TranslateTable[Loop1UInt16].SourceId == Code)
+          {
+            FlagFound = FLAG_ON;
+            break;
+          }
+        }
+
+        if (FlagFound)
+        {
+          /* Send target command. transmit_burst() masks the receiver until our own burst is over. */
+          while (transmit_busy());
+          StepCount = ir_encode_frame(TranslateTable[Loop1UInt16].TargetProtocol, TranslateTable[Loop1UInt16].TargetId, Duration, sizeof(Duration) / sizeof(Duration[0]));
+          if (transmit_burst(Duration, StepCount, TranslateTable[Loop1UInt16].TargetProtocol->CarrierFrequency))
+          {
+            /* Nothing has been sent: TransmitStartTime belongs to a previous burst, keep it out of latency statistics. */
+            printf("0x%8.8llX -> %s 0x%8.8llX   not sent (transmitter busy or empty frame)\r", Code, TranslateTable[Loop1UInt16].TargetProtocol->Name, TranslateTable[Loop1UInt16].TargetId);
+          }
+          else
+          {
+            Latency = (UINT32)(TransmitStartTime - FirstEdgeTime);
+            if (Latency < LatencyMin) LatencyMin = Latency;
+            if (Latency > LatencyMax) LatencyMax = Latency;
+            LatencyTotal += Latency;
+            ++TranslateCount;
+
+            printf("0x%8.8llX -> %s 0x%8.8llX   latency: %6lu usec\r", Code, TranslateTable[Loop1UInt16].TargetProtocol->Name, TranslateTable[Loop1UInt16].TargetId, Latency);
+          }
+        }
+        else
+        {
+          printf("0x%8.8llX -> not in translation table\r", Code);
+        }
+      }
+    }
 
 
-  printf("Current remote control model number is %s\r", RemoteModel);
-  printf("Enter the remote model number if it must be different: ");
-  input_string(Dum1UChar);
-  if ((Dum1UChar[0] != 0x00) && (Dum1UChar[0] != 0x0D))
-    strcpy(RemoteModel, Dum1UChar);
-  printf("\r\r");
+    /* Wait for the rest of the source burst (and our own burst) to be over before listening again. */
+    while ((time_us_64() - IrInitialValue[IrStepCount]) < IrProtocol.Separator);
+    while (time_us_64() < IrReceiveMaskEnd);
+    init_burst_variables();
+  }
+
+
+  printf("\r");
+  printf("Number of translations: %lu\r", TranslateCount);
+  if (TranslateCount)
+    printf("Latency (first edge in to first edge out): min %lu usec   max %lu usec   average %llu usec\r", LatencyMin, LatencyMax, LatencyTotal / TranslateCount);
+  printf("%s\r\r", Separator);
 
   return;
 }
@@ -607,64 +5573,82 @@ void enter_remote_id(void)
 
 
 /* $PAGE */
-/* $TITLE=get_pico_id() */
+/* $TITLE=transmit_burst() */
 /* ------------------------------------------------------------------ *\
-         Determine if the microcontroller is a Pico or a Pico W
-                    and retrieve its Unique Number.
+        Send a list of Mark / Space durations (in micro-seconds)
+                 through the infrared transmitter.
+     Duration[0] is a Mark (carrier on), Duration[1] a Space, etc...
+      Returns as soon as the DMA channel has been started: the PIO
+        state machine times the whole burst without CPU overhead.
+     May be called from interrupt context (see macro_callback()): the
+      transmitter is claimed with interrupts disabled, so that only one
+            caller at a time fills TransmitBuffer and starts it.
 \* ------------------------------------------------------------------ */
-UINT8 get_pico_id(void)
+UINT8 transmit_burst(volatile UINT32 *Duration, UINT16 StepCount, UINT32 CarrierFrequency)
 {
-  UINT8 Loop1UInt8;
-  
-  UINT16 AdcValue1;
-  UINT16 AdcValue2;
-
-  float Volts1;
-  float Volts2;
-
-  pico_unique_board_id_t board_id;  // Pico's Unique ID.
+  UINT16 Loop1UInt16;
+  UINT16 PairCount;
 
+  UINT32 InterruptState;
+  UINT32 Periods[2];
 
-  /* Select power supply input. */
-  adc_select_input(3);
-  gpio_put(PICO_LED, true);
+  UINT64 TotalTime;
 
-  /* Read ADC converter raw value. */
-  AdcValue1 = adc_read();
 
-  /* Convert raw value to voltage value. */
-  Volts1 = (3 * (AdcValue1 * 3.3f / 4096));
+  if (StepCount == 0) return 1;
 
+  /* Claim the transmitter: it remains busy for everybody else until the burst has been started. */
+  InterruptState = save_and_disable_interrupts();
+  if (dma_channel_is_busy(TransmitDmaChannel) || (time_us_64() < TransmitEndTime))
+  {
+    restore_interrupts(InterruptState);
+    return 1;
+  }
+  TransmitEndTime = 0xFFFFFFFFFFFFFFFFll;
+  restore_interrupts(InterruptState);
 
 
-  /* The important power supply value to consider is when GPIO25 is Low. */
-  gpio_put(PICO_LED, false);
-    
-  /* Read ADC converter raw value. */
-  AdcValue2 = adc_read();
+  /* Re-program the PIO clock divider only if carrier frequency changed. */
+  if (CarrierFrequency != TransmitCarrier)
+  {
+    ir_transmit_set_carrier(TRANSMIT_PIO, TransmitStateMachine, CarrierFrequency);
+    TransmitCarrier = CarrierFrequency;
+  }
 
-  /* Convert raw value to voltage value. */
-  Volts2 = (3 * (AdcValue2 * 3.3f / 4096));
-  if (Volts2 > 3)
-    PicoType = TYPE_PICO;
-  else
-    PicoType = TYPE_PICO_W;
 
+  /* Convert micro-seconds to carrier periods and pack each Mark / Space pair in a single 32-bit word for the PIO state machine. */
+  PairCount = 0;
+  TotalTime = 0ll;
+  for (Loop1UInt16 = 0; Loop1UInt16 < StepCount; Loop1UInt16 += 2)
+  {
+    Periods[0] = (UINT32)((((UINT64)Duration[Loop1UInt16] * CarrierFrequency) + 500000ll) / 1000000ll);
+    if ((Loop1UInt16 + 1) < StepCount)
+      Periods[1] = (UINT32)((((UINT64)Duration[Loop1UInt16 + 1] * CarrierFrequency) + 500000ll) / 1000000ll);
+    else
+      Periods[1] = 1;  // burst ends with a Mark, add a minimal Space.
+
+    /* PIO program always sends at least one carrier period and at most 65536. */
+    if (Periods[0] == 0)                    Periods[0] = 1;
+    if (Periods[0] > TRANSMIT_MAX_PERIODS)  Periods[0] = TRANSMIT_MAX_PERIODS;
+    if (Periods[1] == 0)                    Periods[1] = 1;
+    if (Periods[1] > TRANSMIT_MAX_PERIODS)  Periods[1] = TRANSMIT_MAX_PERIODS;
+
+    TransmitBuffer[PairCount++] = ((Periods[1] - 1) << 16) | (Periods[0] - 1);
+    TotalTime += Periods[0] + Periods[1];
+  }
+  TotalTime = ((TotalTime * 1000000ll) / CarrierFrequency) + 1;  // back to micro-seconds.
 
-  /* Retrieve Pico Unique Number from flash memory IC. */
-  pico_get_unique_board_id(&board_id);
 
+  /* Start the DMA transfer. The PIO state machine takes care of the rest.
+     The VS1838b would receive our own infrared light, so mask it until the burst is over. */
+  InterruptState    = save_and_disable_interrupts();
+  TransmitStartTime = time_us_64();
+  TransmitEndTime   = TransmitStartTime + TotalTime;
+  IrReceiveMaskEnd  = TransmitEndTime + TRANSMIT_GUARD_TIME;
+  dma_channel_transfer_from_buffer_now(TransmitDmaChannel, TransmitBuffer, PairCount);
+  restore_interrupts(InterruptState);
 
-  /* Build-up the Unique ID string in hex. */
-  PicoUniqueId[0] = 0x00;  // initialize as null string.
-  for (Loop1UInt8 = 0; Loop1UInt8 < PICO_UNIQUE_BOARD_ID_SIZE_BYTES; ++Loop1UInt8)
-  {
-    sprintf(&PicoUniqueId[strlen(PicoUniqueId)], "%2.2X", board_id.id[Loop1UInt8]);
-    if ((Loop1UInt8 % 2) && (Loop1UInt8 != 7))
-      sprintf(&PicoUniqueId[strlen(PicoUniqueId)], "-");
-  }
-  
-  return PicoType;
+  return 0;
 }
 
 
@@ -672,24 +5656,23 @@ UINT8 get_pico_id(void)
 
 
 /* $PAGE */
-/* $TITLE=init_burst_variables() */
+/* $TITLE=transmit_busy() */
 /* ------------------------------------------------------------------ *\
-    Initialize variables that will receive next infrared data burst.
+      Tell if the infrared transmitter is still sending a burst.
 \* ------------------------------------------------------------------ */
-void init_burst_variables(void)
+UINT8 transmit_busy(void)
 {
-  UINT Loop1UInt;
+  UINT8 FlagBusy;
 
+  UINT32 InterruptState;
 
-  IrStepCount = 0;
 
-  for (Loop1UInt = 0; Loop1UInt < MAX_IR_READINGS; ++Loop1UInt)
-  {
-    IrInitialValue[Loop1UInt] = 0ll;
-    IrFinalValue[Loop1UInt]   = 0ll;
-    IrResultValue[Loop1UInt]  = 0ll;
-    IrLevel[Loop1UInt]        = 2;
-  }
+  /* TransmitEndTime is 64 bits wide and may be written from interrupt context: read it in one go. */
+  InterruptState = save_and_disable_interrupts();
+  FlagBusy = (dma_channel_is_busy(TransmitDmaChannel) || (time_us_64() < TransmitEndTime)) ? FLAG_ON : FLAG_OFF;
+  restore_interrupts(InterruptState);
+
+  return FlagBusy;
 }
 
 
@@ -697,111 +5680,75 @@ void init_burst_variables(void)
 
 
 /* $PAGE */
-/* $TITLE=input_string() */
+/* $TITLE=transmit_command() */
 /* ------------------------------------------------------------------ *\
-                       Read a string from stdin.
+     Encode a frame from protocol name, address and command with the
+      encoder library, display its timing and send it through the
+                        infrared transmitter.
 \* ------------------------------------------------------------------ */
-void input_string(UCHAR *String)
+void transmit_command(void)
 {
-  int8_t DataInput;
+  UCHAR String[128];
 
   UINT8 Loop1UInt8;
 
+  UINT16 Loop1UInt16;
+  UINT16 StepCount;
 
-  Loop1UInt8 = 0;
-  do
-  {
-    DataInput = getchar_timeout_us(50000);
-
-    switch (DataInput)
-    {
-      case (PICO_ERROR_TIMEOUT):
-      case (0):
-        continue;
-      break;
-
-      case (8):
-        /* <Backspace> */
-        if (Loop1UInt8 > 0)
-        {
-          --Loop1UInt8;
-          String[Loop1UInt8] = 0x00;
-          printf("%c %c", 0x08, 0x08);  // erase character under the cursor.
-        }
-      break;
+  UINT32 Address;
+  UINT32 Command;
 
-      case (0x0D):
-        /* <Enter> */
-        if (Loop1UInt8 == 0)
-        {
-          String[Loop1UInt8++] = (UCHAR)DataInput;  
-          String[Loop1UInt8++] = 0x00;
-        }
-        printf("\r");
-      break;
+  UINT64 Code;
 
-      default:
-        printf("%c", (UCHAR)DataInput);
-        String[Loop1UInt8] = (UCHAR)DataInput;
-        // printf("Loop1UInt8: %3u   %2.2X - %c\r", Loop1UInt8, DataInput, DataInput);  ///
-        ++Loop1UInt8;
-      break;
-    }
-  } while((Loop1UInt8 < 128) && (DataInput != 0x0D));
-  
-  String[Loop1UInt8] = '\0';  // end-of-string
+  const struct ir_protocol *Protocol;
 
-  /***
-  for (Loop1UInt8 = 0; Loop1UInt8 < 10; ++Loop1UInt8)
-    printf("%2u:[%2.2X]   ", Loop1UInt8, String[Loop1UInt8]);
-  printf("\r");
-  ***/
+  static UINT32 Duration[(MAX_IR_READINGS / 2) + 1];  // too big for stack.
 
-  return;
-}
 
+  printf("Protocols known by the encoder:");
+  for (Loop1UInt8 = 0; Loop1UInt8 < IrProtocolTotal; ++Loop1UInt8)
+    printf(" %s", IrProtocolTable[Loop1UInt8].Name);
+  printf("\r\r");
 
+  printf("Enter protocol name [%s]: ", IrProtocol.Name);
+  input_string(String);
+  if (String[0] == 0x0D)
+  {
+    Protocol = &IrProtocol;
+  }
+  else
+  {
+    Protocol = ir_protocol_find(String);
+    if (Protocol == NULL)
+    {
+      printf("\rUnknown protocol...\r\r");
+      return;
+    }
+  }
 
+  printf("Enter address (hexadecimal, %u bits): ", Protocol->AddressBits);
+  input_string(String);
+  Address = strtoul(String, NULL, 16);
+  printf("Enter command (hexadecimal, %u bits): ", Protocol->CommandBits);
+  input_string(String);
+  Command = strtoul(String, NULL, 16);
 
 
-/* $PAGE */
-/* $TITLE=isr_signal_trap() */
-/* ----------------------------------------------------------------- *\
-         Interrupt handler for signal received from IR sensor
-                           (type VS1838B).
-\* ----------------------------------------------------------------- */
-gpio_irq_callback_t isr_signal_trap(UINT8 gpio, UINT32 Events)
-{
-  if (gpio == IR_RX)
-  {
-    /* IR line goes from Low to High. */
-    if (Events & GPIO_IRQ_EDGE_RISE)
-    {
-      IrFinalValue[IrStepCount]   = time_us_64();                                                       // this is the final timer value for current Low level.
-      IrResultValue[IrStepCount]  = (UINT32)(IrFinalValue[IrStepCount] - IrInitialValue[IrStepCount]);  // calculate duration of current Low level.
-      IrLevel[IrStepCount]        = 0;                                                                  // identify  as Low level.
-      ++IrStepCount;                                                                                    // start next logic level change.
-      IrInitialValue[IrStepCount] = time_us_64();                                                       // this is also start timer of next High level.
+  Code      = ir_encode_code(Protocol, Address, Command);
+  StepCount = ir_encode_frame(Protocol, Code, Duration, sizeof(Duration) / sizeof(Duration[0]));
 
-      gpio_acknowledge_irq(IR_RX, GPIO_IRQ_EDGE_RISE);
-   }
+  printf("\r");
+  printf("%s frame 0x%8.8llX (address 0x%lX, command 0x%lX): %u steps\r", Protocol->Name, Code, Address, Command, StepCount);
+  for (Loop1UInt16 = 0; Loop1UInt16 < StepCount; ++Loop1UInt16)
+    printf("%5lu%s", Duration[Loop1UInt16], ((Loop1UInt16 % 12) == 11) ? "\r" : " ");
+  printf("\r\r");
 
+  if (transmit_burst(Duration, StepCount, Protocol->CarrierFrequency))
+    printf("Infrared transmitter is busy... try again later.\r\r");
+  else
+    printf("Sending %u steps at %lu Hz through infrared transmitter on GPIO %u.\r\r", StepCount, Protocol->CarrierFrequency, IR_TX);
 
-    /* IR line goes from High to Low. */
-    if (Events & GPIO_IRQ_EDGE_FALL)
-    {
-      if (IrStepCount > 0)
-      {
-        IrFinalValue[IrStepCount]  =  time_us_64();                                                      // this is the final timer value for current High level.
-        IrResultValue[IrStepCount] = (UINT32)(IrFinalValue[IrStepCount] - IrInitialValue[IrStepCount]);  // calculate duration of current High level.
-        IrLevel[IrStepCount]       = 1;                                                                  // identify as High level.
-        ++IrStepCount;                                                                                   // start next logic level change.
-      }
-      IrInitialValue[IrStepCount]  = time_us_64();                                                       // this is also start timer of next Low level.
-      
-      gpio_acknowledge_irq(IR_RX, GPIO_IRQ_EDGE_FALL);
-    }
-  }
+  return;
 }
 
 
@@ -809,16 +5756,34 @@ gpio_irq_callback_t isr_signal_trap(UINT8 gpio, UINT32 Events)
 
 
 /* $PAGE */
-/* $TITLE=tone() */
+/* $TITLE=transmit_init() */
 /* ------------------------------------------------------------------ *\
-         Make a tone for the specified number of milliseconds on
-                             active buzzer.
+       Initialize the PIO state machine and DMA channel used by
+                     the infrared transmitter.
 \* ------------------------------------------------------------------ */
-void tone(UINT16 MilliSeconds)
+void transmit_init(void)
 {
-  gpio_put(BUZZER, 1);
-  sleep_ms(MilliSeconds);
-  gpio_put(BUZZER, 0);
+  UINT Offset;
+
+  dma_channel_config DmaConfig;
+
+
+  /* PIO state machine generating the carrier and timing each Mark / Space pair. */
+  Offset               = pio_add_program(TRANSMIT_PIO, &ir_transmit_program);
+  TransmitStateMachine = pio_claim_unused_sm(TRANSMIT_PIO, true);
+  TransmitCarrier      = TRANSMIT_CARRIER_DEFAULT;
+  TransmitEndTime      = 0ll;
+  ir_transmit_program_init(TRANSMIT_PIO, TransmitStateMachine, Offset, IR_TX, TransmitCarrier);
+
+
+  /* DMA channel feeding Mark / Space pairs to the state machine, paced by the TX FIFO data request. */
+  TransmitDmaChannel = dma_claim_unused_channel(true);
+  DmaConfig = dma_channel_get_default_config(TransmitDmaChannel);
+  channel_config_set_transfer_data_size(&DmaConfig, DMA_SIZE_32);
+  channel_config_set_read_increment(&DmaConfig, true);
+  channel_config_set_write_increment(&DmaConfig, false);
+  channel_config_set_dreq(&DmaConfig, pio_get_dreq(TRANSMIT_PIO, TransmitStateMachine, true));
+  dma_channel_configure(TransmitDmaChannel, &DmaConfig, &TRANSMIT_PIO->txf[TransmitStateMachine], TransmitBuffer, 0, false);
 
   return;
 }
@@ -879,3 +5844,177 @@ void uart_send(UINT16 LineNumber, UCHAR *String)
 
   return;
 }
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=waveform_draw() */
+/* ------------------------------------------------------------------ *\
+     Render last infrared burst as a time-scaled waveform, starting at
+      Start usec (relative to the first falling edge) with Scale usec
+     per column. Steps are walked only once (run-length scaling), so
+     that drawing time depends on the number of steps and columns, not
+      on the duration of the burst. A column holding more than one
+                edge is drawn as '#' (zoom in to see them).
+\* ------------------------------------------------------------------ */
+void waveform_draw(UINT32 Start, UINT32 Scale)
+{
+  UCHAR LineHigh[WAVEFORM_COLUMNS + 1];
+  UCHAR LineLow[WAVEFORM_COLUMNS + 1];
+
+  UINT8 Column;
+  UINT8 EdgeCount;
+  UINT8 Strip;
+
+  UINT16 Step;
+
+  UINT32 ColumnEnd;
+  UINT32 StepEnd;
+
+
+  /* Skip the steps ending before the first column. */
+  Step    = 0;
+  StepEnd = IrResultValue[0];
+  while ((Step < IrStepCount) && (StepEnd <= Start))
+  {
+    ++Step;
+    StepEnd += IrResultValue[Step];
+  }
+
+
+  for (Strip = 0; Strip < WAVEFORM_STRIPS; ++Strip)
+  {
+    for (Column = 0; Column < WAVEFORM_COLUMNS; ++Column)
+    {
+      ColumnEnd = Start + (((Strip * WAVEFORM_COLUMNS) + Column + 1) * Scale);
+
+      /* Count the edges falling inside this column. */
+      EdgeCount = 0;
+      while ((Step < IrStepCount) && (StepEnd < ColumnEnd))
+      {
+        ++Step;
+        StepEnd += IrResultValue[Step];
+        if (EdgeCount < 0xFF) ++EdgeCount;
+      }
+
+      if (EdgeCount > 1)
+      {
+        LineHigh[Column] = ' ';
+        LineLow[Column]  = '#';
+      }
+      else if (EdgeCount == 1)
+      {
+        LineHigh[Column] = ' ';
+        LineLow[Column]  = '|';
+      }
+      else if ((Step < IrStepCount) && ((Step % 2) == 0))
+      {
+        /* Even steps are Low levels (infrared light received). */
+        LineHigh[Column] = ' ';
+        LineLow[Column]  = '_';
+      }
+      else
+      {
+        /* High level, or line idle after the end of the burst. */
+        LineHigh[Column] = '_';
+        LineLow[Column]  = ' ';
+      }
+    }
+    LineHigh[WAVEFORM_COLUMNS] = 0x00;
+    LineLow[WAVEFORM_COLUMNS]  = 0x00;
+
+    printf("%10lu %s\r", Start + (Strip * WAVEFORM_COLUMNS * Scale), LineHigh);
+    printf("           %s\r\r", LineLow);
+  }
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=waveform_view() */
+/* ------------------------------------------------------------------ *\
+     Waveform view of last infrared burst on a VT100 terminal. The
+     screen is redrawn in place after every key ("home" escape, the
+      same way uart_send() handles it):
+        <+> / <->  zoom in / out           <f>  fit the whole burst
+        <<> / <>>  pan half a screen       <Enter>  return to menu
+\* ------------------------------------------------------------------ */
+void waveform_view(void)
+{
+  UCHAR String[16];
+
+  int16_t Key;
+
+  UINT16 Loop1UInt16;
+
+  UINT32 Scale;
+  UINT32 Start;
+  UINT32 TotalTime;
+
+
+  if (IrStepCount == 0)
+  {
+    printf("\r\rNo infrared burst has been received yet...\r\r");
+    return;
+  }
+
+  TotalTime = 0;
+  for (Loop1UInt16 = 0; Loop1UInt16 < IrStepCount; ++Loop1UInt16)
+    TotalTime += IrResultValue[Loop1UInt16];
+
+
+  /* Start with the whole burst on one screen. */
+  Start = 0;
+  Scale = (TotalTime / (WAVEFORM_STRIPS * WAVEFORM_COLUMNS)) + 1;
+
+  strcpy(String, "cls");
+  uart_send(__LINE__, String);
+
+  while (1)
+  {
+    strcpy(String, "home");
+    uart_send(__LINE__, String);
+
+    printf("Waveform of button %s: %u steps, %lu usec   -   %6lu usec per column        \r\r", ButtonName, IrStepCount, TotalTime, Scale);
+    waveform_draw(Start, Scale);
+    printf("<+> / <-> zoom   <<> / <>> pan   <f> fit   <Enter> return to menu\r");
+
+    while ((Key = getchar_timeout_us(0)) == PICO_ERROR_TIMEOUT) event_wait();
+
+    switch (Key)
+    {
+      case ('+'):
+        if (Scale > 1) Scale /= 2;
+      break;
+
+      case ('-'):
+        if (Scale < (TotalTime / WAVEFORM_COLUMNS)) Scale *= 2;
+      break;
+
+      case ('<'):
+      case (','):
+        Start = (Start > ((WAVEFORM_STRIPS * WAVEFORM_COLUMNS * Scale) / 2)) ? (Start - ((WAVEFORM_STRIPS * WAVEFORM_COLUMNS * Scale) / 2)) : 0;
+      break;
+
+      case ('>'):
+      case ('.'):
+        if ((Start + ((WAVEFORM_STRIPS * WAVEFORM_COLUMNS * Scale) / 2)) < TotalTime) Start += (WAVEFORM_STRIPS * WAVEFORM_COLUMNS * Scale) / 2;
+      break;
+
+      case ('f'):
+      case ('F'):
+        Start = 0;
+        Scale = (TotalTime / (WAVEFORM_STRIPS * WAVEFORM_COLUMNS)) + 1;
+      break;
+
+      case (0x0D):
+      return;
+    }
+  }
+}
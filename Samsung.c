@@ -20,11 +20,26 @@
 \* ------------------------------------------------------------------ */
 #include "Samsung.h"
 
-#define NUMBER_OF_BITS             32  // number of bits in the infrared data stream.
-#define NUMBER_OF_STEPS           135  // normal count for total number of steps for this remote control unit.
-#define NUMBER_OF_WAKEUP_STEPS      2  // number of steps in the "get-ready" / "start bit" / "wake-up".
-#define SEPARATOR               10000  // a duration greater than 10000 usec is considered a separator.
-#define TRIGGER_POINT_0_1         750  // trigger point between a "0" bit and a "1" bit (shorter than 750 usec = 0  /  longer that 750 usec = 1)
+#define NUMBER_OF_BITS             SAMSUNG_NUMBER_OF_BITS  // number of bits in the infrared data stream.
+#define NUMBER_OF_STEPS                               135  // normal count for total number of steps for this remote control unit.
+#define NUMBER_OF_WAKEUP_STEPS                          2  // number of steps in the "get-ready" / "start bit" / "wake-up".
+#define SEPARATOR                       SAMSUNG_SEPARATOR  // a duration greater than 10000 usec is considered a separator.
+#define TRIGGER_POINT_0_1       SAMSUNG_TRIGGER_POINT_0_1  // trigger point between a "0" bit and a "1" bit (shorter than 750 usec = 0  /  longer that 750 usec = 1)
+
+
+/* Protocol descriptor used by the generic decoder / encoder (translator mode, etc...). */
+struct ir_protocol IrProtocol = SAMSUNG_PROTOCOL;
+
+
+/* Button names of this remote control, in the order of the decoder below (template for a bulk-learning session). */
+const UCHAR *ButtonTemplate[] =
+{
+  "Power", "TV", "1", "2", "3", "4", "5", "6", "7", "8", "9", "0", "-", "Pre-Ch", "Mute",
+  "Source", "Volume Up", "Volume Down", "Channel Up", "Channel Down", "Menu", "Ch List",
+  "W. Link", "Tools", "Return", "Info", "Exit", "Up", "Down", "Left", "Right", "Enter",
+  "Red", "Green", "Yellow", "Blue", "CC", "MTS", "DMA", "E.Mode", "P.Size", "Fav.Ch.",
+  "Rewind", "Pause", "Forward", "Play", "Stop", NULL
+};
 
 
 UINT8 decode_ir_command(UINT8 *IrCommand)
@@ -1,2 +1,24 @@
+#ifndef SAMSUNG_H
+#define SAMSUNG_H
+
 #define IR_COMMAND_TO_EXECUTE 1
-/// #define IR_BUTTON_...
\ No newline at end of file
+/// #define IR_BUTTON_...
+
+/* Protocol parameters of this remote control, shared by Samsung.c (IrProtocol) and the encoder (IrProtocolTable in IrEncode.c). */
+#define SAMSUNG_CARRIER_FREQUENCY       37900  // carrier frequency (in Hz).
+#define SAMSUNG_HEADER_LOW               4450  // "get-ready" Low level (in usec).
+#define SAMSUNG_HEADER_HIGH              4450  // "get-ready" High level (in usec).
+#define SAMSUNG_BIT_LOW                   550  // Low level of every data bit (in usec).
+#define SAMSUNG_ZERO_HIGH                 550  // High level of a "0" bit (in usec).
+#define SAMSUNG_ONE_HIGH                 1675  // High level of a "1" bit (in usec).
+#define SAMSUNG_NUMBER_OF_BITS             32  // number of bits in the infrared data stream.
+#define SAMSUNG_ADDRESS_BITS               16  // number of address bits (first bits received).
+#define SAMSUNG_COMMAND_BITS                8  // number of command bits (following the address bits, the rest being check bits).
+#define SAMSUNG_TRIGGER_POINT_0_1         750  // trigger point between a "0" bit and a "1" bit (in usec).
+#define SAMSUNG_SEPARATOR               10000  // a duration greater than this is a separator (in usec).
+
+/* Protocol descriptor initializer (see struct ir_protocol in IrEncode.h). */
+#define SAMSUNG_PROTOCOL {"Samsung", SAMSUNG_CARRIER_FREQUENCY, SAMSUNG_HEADER_LOW, SAMSUNG_HEADER_HIGH, SAMSUNG_BIT_LOW, SAMSUNG_ZERO_HIGH, SAMSUNG_ONE_HIGH, \
+                         SAMSUNG_NUMBER_OF_BITS, SAMSUNG_ADDRESS_BITS, SAMSUNG_COMMAND_BITS, SAMSUNG_TRIGGER_POINT_0_1, SAMSUNG_SEPARATOR}
+
+#endif  // SAMSUNG_H
@@ -0,0 +1,161 @@
+/* ================================================================== *\
+   ir_encode_test.c
+   Pico-Remote-Analyzer encoder round-trip test (host tool).
+
+   Encodes the commands documented in the remote control files with
+   the encoder (IrEncode.c), decodes the durations back with the same
+   rules as decode_ir_data() in the firmware, and checks that both
+   give the same command (with a buffer larger than one frame as well
+   as with a buffer holding exactly one frame):
+      Samsung address 0xE0E0, command 0x40  ->  0xE0E040BF
+      Memorex address 0x2525, command 0x60  ->  0x2525609F
+
+   Build and run (see CMakeLists.txt in this directory):
+      cmake -S tools -B build-host && cmake --build build-host
+      ctest --test-dir build-host --output-on-failure
+\* ================================================================== */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "IrEncode.h"
+
+#define PROTOCOL_TOLERANCE  25  // same as the firmware.
+#define RING_SIZE           80  // room for one frame, written near the end so that the ring wraps around.
+
+
+/* Number of checks that failed. */
+static int FailCount;
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=decode_frame() */
+/* ------------------------------------------------------------------ *\
+     Decode the durations of a frame with the rules of decode_ir_data()
+          in the firmware. Returns 0 when a frame has been decoded.
+\* ------------------------------------------------------------------ */
+static int decode_frame(const struct ir_protocol *Protocol, const uint32_t *Duration, uint16_t StepCount, uint64_t *Code)
+{
+  uint8_t BitNumber;
+
+
+  *Code = 0ull;
+
+  if (StepCount < (2 + (Protocol->NumberOfBits * 2))) return 1;
+  if ((Duration[0] < ((Protocol->HeaderLow * (100u - PROTOCOL_TOLERANCE)) / 100u)) || (Duration[0] > ((Protocol->HeaderLow * (100u + PROTOCOL_TOLERANCE)) / 100u))) return 1;
+
+  for (BitNumber = 0; BitNumber < Protocol->NumberOfBits; ++BitNumber)
+  {
+    if (Duration[2 + (BitNumber * 2)] > Protocol->TriggerPoint01) return 1;
+    if (Duration[3 + (BitNumber * 2)] >= (Protocol->TriggerPoint01 * 4u)) return 1;
+    *Code <<= 1;
+    if (Duration[3 + (BitNumber * 2)] > Protocol->TriggerPoint01) ++*Code;
+  }
+
+  return 0;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=round_trip() */
+/* ------------------------------------------------------------------ *\
+     Encode (address, command) with a protocol of the table, check the
+       code, the frame and the ring, and decode the frame back.
+\* ------------------------------------------------------------------ */
+static void round_trip(const char *Name, uint32_t Address, uint32_t Command, uint64_t Expected)
+{
+  int FailStart;
+
+  uint16_t Head;
+  uint16_t Loop1UInt16;
+  uint16_t StepCount;
+
+  uint32_t Duration[100];
+  uint32_t Exact[100];
+  uint32_t Ring[RING_SIZE];
+
+  uint64_t Code;
+  uint64_t Decoded;
+
+  const struct ir_protocol *Protocol;
+
+
+  FailStart = FailCount;
+  Protocol  = ir_protocol_find(Name);
+  if (Protocol == NULL)
+  {
+    printf("FAIL %s: protocol not found\n", Name);
+    ++FailCount;
+    return;
+  }
+
+  Code = ir_encode_code(Protocol, Address, Command);
+  if (Code != Expected)
+  {
+    printf("FAIL %s: code 0x%8.8llX, expected 0x%8.8llX\n", Name, (unsigned long long)Code, (unsigned long long)Expected);
+    ++FailCount;
+  }
+
+  StepCount = ir_encode_frame(Protocol, Code, Duration, sizeof(Duration) / sizeof(Duration[0]));
+  if (StepCount != ir_encode_length(Protocol))
+  {
+    printf("FAIL %s: %u steps, expected %u\n", Name, StepCount, ir_encode_length(Protocol));
+    ++FailCount;
+    return;
+  }
+
+  if ((decode_frame(Protocol, Duration, StepCount, &Decoded) != 0) || (Decoded != Code))
+  {
+    printf("FAIL %s: frame decodes to 0x%8.8llX, expected 0x%8.8llX\n", Name, (unsigned long long)Decoded, (unsigned long long)Code);
+    ++FailCount;
+  }
+
+  /* A buffer holding exactly one frame must give the same frame (the ring head then wraps to 0). */
+  if ((ir_encode_frame(Protocol, Code, Exact, StepCount) != StepCount) || (memcmp(Exact, Duration, StepCount * sizeof(Duration[0])) != 0))
+  {
+    printf("FAIL %s: exact-size buffer (%u entries) gives a different frame\n", Name, StepCount);
+    ++FailCount;
+  }
+
+  /* The ring must hold the same durations, wrapping around at its end. */
+  Head = ir_encode_ring(Protocol, Code, Ring, RING_SIZE, RING_SIZE - 3);
+  if (Head != ((RING_SIZE - 3 + StepCount) % RING_SIZE))
+  {
+    printf("FAIL %s: ring head %u, expected %u\n", Name, Head, (RING_SIZE - 3 + StepCount) % RING_SIZE);
+    ++FailCount;
+  }
+  for (Loop1UInt16 = 0; Loop1UInt16 < StepCount; ++Loop1UInt16)
+  {
+    if (Ring[(RING_SIZE - 3 + Loop1UInt16) % RING_SIZE] != Duration[Loop1UInt16])
+    {
+      printf("FAIL %s: ring step %u differs from frame\n", Name, Loop1UInt16);
+      ++FailCount;
+      break;
+    }
+  }
+
+  printf("%s %s: 0x%4.4lX / 0x%2.2lX -> 0x%8.8llX (%u steps)\n", (FailCount != FailStart) ? "FAIL" : "ok  ", Name, (unsigned long)Address, (unsigned long)Command, (unsigned long long)Code, StepCount);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=main() */
+int main(void)
+{
+  round_trip("Samsung", 0xE0E0, 0x40, 0xE0E040BFull);
+  round_trip("memorex", 0x2525, 0x60, 0x2525609Full);  // ir_protocol_find() is case insensitive.
+
+  printf("%s\n", (FailCount) ? "FAILED" : "PASSED");
+
+  return (FailCount) ? 1 : 0;
+}
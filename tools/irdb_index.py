@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+# ==================================================================== #
+#   irdb_index.py
+#   Pico-Remote-Analyzer offline code database import (host tool).
+#
+#   Convert an IRDB-style infrared code database into IrDatabase.c, a
+#   constant index sorted by command, built into the firmware (see
+#   IrDatabase.h).
+#
+#   Input may be given as:
+#   - CSV files with a header line holding the columns
+#        brand, type, functionname, protocol, device, subdevice, function
+#   - directories laid out as the IRDB repository
+#        <Brand>/<Type>/<device>,<subdevice>.csv
+#     where every file holds the columns
+#        functionname, protocol, device, subdevice, function
+#     (brand and type are then taken from the directory names).
+#
+#   Only protocols sending 32 data bits as device, subdevice, function
+#   and complemented function (least significant bit first), as decoded
+#   by the firmware, are imported. Other codes are counted and skipped.
+#
+#   Usage:
+#      python3 tools/irdb_index.py [-o IrDatabase.c] <csv file or directory> ...
+# ==================================================================== #
+import argparse
+import csv
+import os
+import sys
+
+
+# Protocols of the NEC family: the subdevice used when the database leaves it empty (-1).
+PROTOCOLS = {
+    "nec":      lambda device: (~device) & 0xFF,
+    "nec1":     lambda device: (~device) & 0xFF,
+    "nec2":     lambda device: (~device) & 0xFF,
+    "necx1":    lambda device: device,
+    "necx2":    lambda device: device,
+    "samsung32": lambda device: device,
+}
+
+
+
+def reverse8(value):
+    """Reverse the bit order of a byte."""
+    return int("{:08b}".format(value & 0xFF)[::-1], 2)
+
+
+
+def encode_code(protocol, device, subdevice, function):
+    """Command as decoded by the firmware (most significant bit first), None if not supported."""
+    protocol = protocol.strip().lower().replace("-", "").replace("_", "")
+    if protocol not in PROTOCOLS:
+        return None
+    if not (0 <= device <= 0xFF) or not (0 <= function <= 0xFF) or (subdevice > 0xFF):
+        return None
+    if subdevice < 0:
+        subdevice = PROTOCOLS[protocol](device)
+
+    return ((reverse8(device) << 24) | (reverse8(subdevice) << 16) | (reverse8(function) << 8) | reverse8(~function))
+
+
+
+def read_rows(path, brand=None, type_name=None):
+    """Yield (brand, type, function name, protocol, device, subdevice, function) from one CSV file."""
+    with open(path, newline="", encoding="utf-8", errors="replace") as handle:
+        for row in csv.DictReader(handle):
+            row = {(key or "").strip().lower(): (value or "").strip() for key, value in row.items()}
+            try:
+                yield (brand or row["brand"], type_name or row["type"], row["functionname"], row["protocol"],
+                       int(row["device"] or -1), int(row["subdevice"] or -1), int(row["function"] or -1))
+            except (KeyError, ValueError):
+                continue
+
+
+
+def read_inputs(paths):
+    """Yield the rows of every CSV file given, or found in an IRDB directory tree."""
+    for path in paths:
+        if os.path.isdir(path):
+            for root, directories, files in os.walk(path):
+                directories.sort()
+                parts = os.path.relpath(root, path).split(os.sep)
+                if len(parts) < 2:
+                    continue
+                for name in sorted(files):
+                    if name.lower().endswith(".csv"):
+                        yield from read_rows(os.path.join(root, name), parts[-2], parts[-1])
+        else:
+            yield from read_rows(path)
+
+
+
+def c_string(text):
+    """C string literal."""
+    return '"' + text.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build IrDatabase.c from an IRDB-style code database.")
+    parser.add_argument("-o", "--output", default="IrDatabase.c", help="generated C file (default: IrDatabase.c)")
+    parser.add_argument("inputs", nargs="+", help="CSV files or IRDB directories")
+    arguments = parser.parse_args()
+
+    devices   = {}
+    functions = {}
+    entries   = set()
+    skipped   = 0
+
+    for brand, type_name, function_name, protocol, device, subdevice, function in read_inputs(arguments.inputs):
+        code = encode_code(protocol, device, subdevice, function)
+        if code is None:
+            skipped += 1
+            continue
+        device_index   = devices.setdefault((brand, type_name), len(devices))
+        function_index = functions.setdefault(function_name, len(functions))
+        entries.add((code, device_index, function_index))
+
+    if not entries:
+        sys.exit("irdb_index.py: no supported code found.")
+    if (len(devices) > 0xFFFF) or (len(functions) > 0xFFFF):
+        sys.exit("irdb_index.py: too many devices or function names for a 16-bit index.")
+
+    # Sort by command first, so that the firmware finds a command by binary search.
+    device_list   = list(devices)
+    function_list = list(functions)
+    entries = sorted(entries, key=lambda entry: (entry[0], device_list[entry[1]], function_list[entry[2]]))
+
+    with open(arguments.output, "w", encoding="utf-8") as output:
+        output.write("/* ================================================================== *\\\n")
+        output.write("   IrDatabase.c\n")
+        output.write("   Generated by tools/irdb_index.py (see IrDatabase.h): do not edit.\n")
+        output.write("   %u codes, %u devices, %u function names (%u codes skipped).\n" % (len(entries), len(devices), len(functions), skipped))
+        output.write("\\* ================================================================== */\n")
+        output.write("#include \"IrDatabase.h\"\n\n\n")
+
+        output.write("const struct ir_database_device IrDatabaseDevice[] =\n{\n")
+        for brand, type_name in devices:
+            output.write("  {%s, %s},\n" % (c_string(brand), c_string(type_name)))
+        output.write("};\n\n")
+
+        output.write("const char *const IrDatabaseFunction[] =\n{\n")
+        for function_name in functions:
+            output.write("  %s,\n" % c_string(function_name))
+        output.write("};\n\n")
+
+        output.write("const struct ir_database_entry IrDatabase[] =\n{\n")
+        for code, device_index, function_index in entries:
+            output.write("  {0x%8.8X, %5u, %5u},\n" % (code, device_index, function_index))
+        output.write("};\n\n")
+
+        output.write("const uint32_t IrDatabaseTotal = sizeof(IrDatabase) / sizeof(IrDatabase[0]);\n")
+
+    print("%s: %u codes, %u devices, %u function names (%u codes skipped)." % (arguments.output, len(entries), len(devices), len(functions), skipped))
+
+
+
+if __name__ == "__main__":
+    main()
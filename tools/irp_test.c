@@ -0,0 +1,147 @@
+/* ================================================================== *\
+   irp_test.c
+   Pico-Remote-Analyzer IRP notation interpreter test (host tool).
+
+   Compiles IRP strings with the interpreter (IrIrp.c), encodes a
+   command, decodes the durations back and checks that the variables
+   are the same:
+      NEC1     D=0x04, S=0xFB, F=0x08 (with its repeated part)
+      Samsung  D=0x07, S=0x07, F=0x02  (0xE0E040BF as decoded by the
+                                        firmware, most significant bit first)
+   The burst must still decode with every duration stretched by 15%,
+   and must be rejected once a bit of the ~F check byte is flipped.
+   A malformed string must be rejected at the position of the error.
+
+   Build and run (see CMakeLists.txt in this directory):
+      cmake -S tools -B build-host && cmake --build build-host
+      ctest --test-dir build-host --output-on-failure
+\* ================================================================== */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "IrIrp.h"
+
+#define MAX_DURATIONS  200  // room for a frame and a few repeated parts.
+#define STRETCH_PERCENT 15  // every duration made this much longer (within IRP_TOLERANCE).
+
+
+/* Number of checks that failed. */
+static int FailCount;
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=round_trip() */
+/* ------------------------------------------------------------------ *\
+      Compile an IRP string, encode (D, S, F) with Repeat repeated
+     parts, check the number of durations and decode them back, as
+     received, stretched, and with bit CheckBit (from the beginning of
+          the burst) of the ~F check byte flipped.
+\* ------------------------------------------------------------------ */
+static void round_trip(const char *Name, const char *Text, uint32_t D, uint32_t S, uint32_t F, uint8_t Repeat, uint16_t Expected, uint16_t CheckBit)
+{
+  int FailStart;
+
+  uint16_t ErrorPosition;
+  uint16_t Index;
+  uint16_t Loop1UInt16;
+  uint16_t StepCount;
+
+  uint32_t Duration[MAX_DURATIONS];
+  uint32_t Swap;
+  uint32_t Variable[IRP_VARIABLES];
+  uint32_t Decoded[IRP_VARIABLES];
+
+  static struct irp_program Program;
+
+
+  FailStart = FailCount;
+  memset(&Program, 0, sizeof(Program));
+  ErrorPosition = irp_compile(Text, &Program);
+  if (ErrorPosition)
+  {
+    printf("FAIL %s: compile error at position %u\n", Name, ErrorPosition);
+    ++FailCount;
+    return;
+  }
+
+  memset(Variable, 0, sizeof(Variable));
+  Variable['D' - 'A'] = D;
+  Variable['S' - 'A'] = S;
+  Variable['F' - 'A'] = F;
+
+  StepCount = irp_encode(&Program, Variable, Repeat, Duration, MAX_DURATIONS);
+  if (StepCount != Expected)
+  {
+    printf("FAIL %s: %u durations, expected %u\n", Name, StepCount, Expected);
+    ++FailCount;
+    return;
+  }
+
+  /* As encoded. */
+  if ((irp_decode(&Program, Duration, StepCount, Decoded) != 0) || (Decoded['D' - 'A'] != D) || (Decoded['S' - 'A'] != S) || (Decoded['F' - 'A'] != F))
+  {
+    printf("FAIL %s: burst doesn't decode to the values encoded\n", Name);
+    ++FailCount;
+  }
+
+  /* Stretched timing (a slow remote control). */
+  for (Loop1UInt16 = 0; Loop1UInt16 < StepCount; ++Loop1UInt16)
+    Duration[Loop1UInt16] = (Duration[Loop1UInt16] * (100 + STRETCH_PERCENT)) / 100;
+  if ((irp_decode(&Program, Duration, StepCount, Decoded) != 0) || (Decoded['F' - 'A'] != F))
+  {
+    printf("FAIL %s: burst stretched by %u%% doesn't decode\n", Name, STRETCH_PERCENT);
+    ++FailCount;
+  }
+
+  /* Flip one bit of the ~F check byte: its gap becomes the gap of the other bit value. */
+  Index = 2 + (CheckBit * 2) + 1;
+  Swap  = (Duration[Index] > (Duration[Index - 1] * 2)) ? Duration[Index - 1] : (Duration[Index - 1] * 3);
+  Duration[Index] = Swap;
+  if (irp_decode(&Program, Duration, StepCount, Decoded) == 0)
+  {
+    printf("FAIL %s: corrupted ~F check byte is not rejected\n", Name);
+    ++FailCount;
+  }
+
+  printf("%s %s: D=0x%2.2lX S=0x%2.2lX F=0x%2.2lX (%u durations)\n", (FailCount != FailStart) ? "FAIL" : "ok  ", Name, (unsigned long)D, (unsigned long)S, (unsigned long)F, StepCount);
+
+  return;
+}
+
+
+
+
+
+/* $PAGE */
+/* $TITLE=main() */
+int main(void)
+{
+  uint16_t ErrorPosition;
+
+  static struct irp_program Program;
+
+
+  /* Frame: 2 header durations, 32 bits and the stop flash; each repeated part: 2 durations and the stop flash (the trailing gap is merged into the next flash or dropped). */
+  round_trip("NEC1",    "{38.4k,564}<1,-1|1,-3>(16,-8,D:8,S:8,F:8,~F:8,1,^108m,(16,-4,1,^108m)*)", 0x04, 0xFB, 0x08, 2, 67 + (2 * 4), 24);
+  round_trip("Samsung", "{38k,564}<1,-1|1,-3>(8,-8,D:8,S:8,F:8,~F:8,1,^108m)",                     0x07, 0x07, 0x02, 0, 67,           31);
+
+  /* Missing ':' after a field name: error at the first character that doesn't fit. */
+  memset(&Program, 0, sizeof(Program));
+  ErrorPosition = irp_compile("{38k,564}<1,-1|1,-3>(8,-8,D8)", &Program);
+  if (ErrorPosition == 0)
+  {
+    printf("FAIL malformed string is accepted\n");
+    ++FailCount;
+  }
+  else
+  {
+    printf("ok   malformed string rejected at position %u\n", ErrorPosition);
+  }
+
+  printf("%s\n", (FailCount) ? "FAILED" : "PASSED");
+
+  return (FailCount) ? 1 : 0;
+}